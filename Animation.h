@@ -0,0 +1,36 @@
+#pragma once
+
+#include <gl/glew.h>
+
+// Effects evaluated per glyph in the vertex shader, from the glyph's index and
+// pen position and the time of the frame, so animated text is printed exactly
+// like static text. Colours can't be animated: the rasterizer's colour
+// channels count coverage, so effects only move and scale glyphs. The values
+// are those the shader switches on.
+enum class Effect
+{
+    None,
+    // Glyphs bob up and down by amplitude, speed radians a second and phase radians apart
+    Wave,
+    // Speed glyphs a second appear, one after another
+    Typewriter,
+    // Glyphs scroll left by speed units a second and wrap within amplitude units
+    Ticker,
+    // Glyphs grow from nothing at speed times a second, phase seconds apart
+    PopIn,
+};
+
+struct Animation
+{
+    Effect effect;
+    GLfloat amplitude;
+    GLfloat speed;
+    GLfloat phase;
+
+    bool operator==(const Animation& other) const
+    {
+        return effect == other.effect && amplitude == other.amplitude && speed == other.speed && phase == other.phase;
+    }
+};
+
+const Animation Static = { Effect::None, 0.f, 0.f, 0.f };
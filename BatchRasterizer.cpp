@@ -0,0 +1,130 @@
+#include "BatchRasterizer.h"
+#include "Font.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <glm/gtx/transform.hpp>
+
+// Keeps the subpixel filter of one tile from reading its neighbours
+constexpr float Padding = 2.f;
+
+BatchRasterizer::BatchRasterizer(Renderer& renderer, Font& font, GLsizei tileWidth, GLsizei tileHeight, GLsizei columns, GLsizei rows, size_t ring) :
+    renderer(renderer),
+    font(font),
+    tileWidth(tileWidth),
+    tileHeight(tileHeight),
+    columns(columns),
+    rows(rows),
+    buffers(ring),
+    fences(ring, nullptr),
+    firsts(ring),
+    counts(ring)
+{
+    for (auto b : buffers)
+    {
+        gl.BindBuffer(GL_PIXEL_PACK_BUFFER, b);
+        gl.BufferData(GL_PIXEL_PACK_BUFFER, tileWidth * columns * tileHeight * rows * 3, nullptr, GL_STREAM_READ);
+    }
+
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+BatchRasterizer::~BatchRasterizer()
+{
+    for (auto f : fences)
+        if (f)
+            gl.DeleteSync(f);
+}
+
+void BatchRasterizer::Rasterize(const char* const* strs, size_t count, float scale, const TileCallback& callback)
+{
+    GLsizei width = tileWidth * columns;
+    GLsizei height = tileHeight * rows;
+    size_t tiles = (size_t)columns * rows;
+    size_t ring = buffers.size();
+    size_t batch = 0;
+
+    gl.PixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    for (size_t first = 0; first < count; first += tiles, batch++)
+    {
+        size_t slot = batch % ring;
+
+        // The frame read into this buffer a full ring ago is surely done by now
+        if (fences[slot])
+            Deliver(slot, callback);
+
+        size_t n = min(tiles, count - first);
+
+        renderer.BeginFrame(target, width, height);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const char* str = strs[first + i];
+            TextMetrics metrics = font.Measure(str);
+
+            float w = metrics.bounds.z - metrics.bounds.x;
+            float h = metrics.bounds.w - metrics.bounds.y;
+            float s = scale;
+
+            if (w * s > tileWidth - 2.f * Padding)
+                s = (tileWidth - 2.f * Padding) / w;
+            if (h * s > tileHeight - 2.f * Padding)
+                s = (tileHeight - 2.f * Padding) / h;
+
+            float x = ((i % columns) + 0.5f) * tileWidth - width / 2.f;
+            float y = ((i / columns) + 0.5f) * tileHeight - height / 2.f;
+
+            renderer.Push();
+            renderer.Multiply(glm::translate(glm::vec3(x, y, 0.f)));
+            renderer.Multiply(glm::scale(glm::vec3(s, s, 1.f)));
+            renderer.Print(font, -(metrics.bounds.x + metrics.bounds.z) / 2.f, -(metrics.bounds.y + metrics.bounds.w) / 2.f, str);
+            renderer.Pop();
+        }
+
+        renderer.Draw();
+
+        GLsizei used = (GLsizei)((n + columns - 1) / columns) * tileHeight;
+
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, target.ResolvedFramebuffer());
+        gl.BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+        gl.ReadPixels(0, 0, width, used, GL_RGB, GL_UNSIGNED_BYTE, 0);
+        gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        fences[slot] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        firsts[slot] = first;
+        counts[slot] = n;
+    }
+
+    // Whatever is still in flight, oldest first
+    for (size_t i = 0; i < ring; i++)
+    {
+        size_t slot = (batch + i) % ring;
+
+        if (fences[slot])
+            Deliver(slot, callback);
+    }
+}
+
+void BatchRasterizer::Deliver(size_t slot, const TileCallback& callback)
+{
+    while (gl.ClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+    gl.DeleteSync(fences[slot]);
+    fences[slot] = nullptr;
+
+    GLsizei stride = tileWidth * columns * 3;
+    GLsizei used = (GLsizei)((counts[slot] + columns - 1) / columns) * tileHeight;
+
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+
+    auto pixels = (const unsigned char*)gl.MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, stride * used, GL_MAP_READ_BIT);
+
+    if (pixels)
+        for (size_t i = 0; i < counts[slot]; i++)
+        {
+            const unsigned char* tile = pixels + (i / columns) * tileHeight * stride + (i % columns) * tileWidth * 3;
+            callback(firsts[slot] + i, tile, tileWidth, tileHeight, stride);
+        }
+
+    gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Buffer.h"
+#include "RenderTarget.h"
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+class Font;
+class Renderer;
+
+// Receives the resolved RGB pixels of the string with the given index, rows
+// bottom-up and stride bytes apart. The pixels are only valid during the call.
+typedef function<void(size_t index, const unsigned char* pixels, GLsizei width, GLsizei height, GLsizei stride)> TileCallback;
+
+// Rasterizes strings offscreen, each one centered in its own tile of a large
+// frame. A frame of tiles is read back into one of a ring of pixel buffers,
+// which is only mapped once the following frames have been drawn, so the
+// transfer overlaps their rendering.
+class BatchRasterizer
+{
+    Renderer& renderer;
+    Font& font;
+
+    RenderTarget target;
+
+    GLsizei tileWidth;
+    GLsizei tileHeight;
+    GLsizei columns;
+    GLsizei rows;
+
+    Buffers buffers;
+    vector<GLsync> fences;
+    vector<size_t> firsts;
+    vector<size_t> counts;
+
+    void Deliver(size_t slot, const TileCallback& callback);
+public:
+    BatchRasterizer(Renderer& renderer, Font& font, GLsizei tileWidth, GLsizei tileHeight, GLsizei columns, GLsizei rows, size_t ring = 3);
+    ~BatchRasterizer();
+
+    // Strings are drawn at up to scale pixels per font unit, smaller if they don't fit their tile
+    void Rasterize(const char* const* strs, size_t count, float scale, const TileCallback& callback);
+};
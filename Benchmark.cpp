@@ -0,0 +1,473 @@
+#include "Benchmark.h"
+#include "BatchRasterizer.h"
+#include "Font.h"
+#include "GL.h"
+#include "Layout.h"
+#include "Renderer.h"
+#include "ScrollView.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <glm/gtx/transform.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const char* const Printable = " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+
+static vector<string> RandomStrings(size_t count, size_t minLength, size_t maxLength)
+{
+    mt19937 random(42);
+    uniform_int_distribution<size_t> length(minLength, maxLength);
+    uniform_int_distribution<int> character(' ', '~');
+
+    vector<string> strings(count);
+    for (auto& s : strings)
+        for (size_t i = length(random); i > 0; i--)
+            s += (char)character(random);
+
+    return strings;
+}
+
+template<typename F>
+static double Seconds(F f)
+{
+    auto begin = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+void BenchmarkMeasure(Font& font)
+{
+    const size_t Count = 10000;
+    const int Repeats = 100;
+
+    vector<string> strings = RandomStrings(Count, 4, 48);
+    vector<const char*> strs;
+    size_t chars = 0;
+
+    for (auto& s : strings)
+    {
+        strs.push_back(s.c_str());
+        chars += s.size();
+    }
+
+    vector<TextMetrics> metrics(Count);
+    volatile GLfloat sink = 0.f;
+
+    double advance = Seconds([&]
+    {
+        for (int r = 0; r < Repeats; r++)
+            for (auto s : strs)
+                sink = sink + font.Advance(s);
+    });
+
+    double measure = Seconds([&]
+    {
+        for (int r = 0; r < Repeats; r++)
+            font.Measure(strs.data(), Count, metrics.data());
+    });
+
+    unsigned threads = max(1u, thread::hardware_concurrency());
+
+    double parallel = Seconds([&]
+    {
+        vector<thread> workers;
+        size_t chunk = (Count + threads - 1) / threads;
+
+        for (size_t begin = 0; begin < Count; begin += chunk)
+            workers.emplace_back([&, begin]
+            {
+                size_t count = min(chunk, Count - begin);
+                for (int r = 0; r < Repeats; r++)
+                    font.Measure(&strs[begin], count, &metrics[begin]);
+            });
+
+        for (auto& w : workers)
+            w.join();
+    });
+
+    auto report = [&](const char* name, double seconds)
+    {
+        cout << name << ": " << Count * Repeats / seconds << " strings/s, "
+            << seconds * 1e9 / (chars * Repeats) << " ns/char" << endl;
+    };
+
+    report("Advance", advance);
+    report("Measure", measure);
+    report(("Measure x" + to_string(threads) + " threads").c_str(), parallel);
+}
+
+static string RandomText(mt19937& random, size_t length)
+{
+    uniform_int_distribution<int> word(1, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+
+    string text;
+    while (text.size() < length)
+    {
+        for (int i = word(random); i > 0; i--)
+            text += (char)letter(random);
+        text += ' ';
+    }
+
+    return text;
+}
+
+void BenchmarkLayout(Font& font)
+{
+    const int Keystrokes = 1000;
+
+    mt19937 random(42);
+
+    for (size_t count = 100; count <= 100000; count *= 10)
+    {
+        string text;
+        for (size_t i = 0; i < count; i++)
+            text += RandomText(random, 300) + '\n';
+
+        Layout layout(font, 600.f, 38.f);
+        layout.SetText(text.c_str());
+
+        uniform_int_distribution<size_t> paragraph(0, layout.Paragraphs() - 1);
+
+        // Keystrokes somewhere in the middle of a paragraph, each undone by the next
+        auto type = [&](const char* str)
+        {
+            return Seconds([&]
+            {
+                for (int k = 0; k < Keystrokes; k++)
+                {
+                    size_t p = paragraph(random);
+                    size_t offset = layout[p].text.size() / 2;
+
+                    layout.Insert(p, offset, str);
+                    layout.Erase(p, offset, strlen(str));
+                }
+            }) / (Keystrokes * 2);
+        };
+
+        // A character, Enter and Backspace joining the paragraphs again, and a
+        // word long enough to rewrap the paragraph into more lines
+        double character = type("x");
+        double enter = type("\n");
+        double word = type(" a phrase wider than a whole line of the layout ");
+        double full = Seconds([&]
+        {
+            layout.SetWidth(600.f);
+        });
+
+        cout << "Layout of " << count << " paragraphs, " << layout.Lines() << " lines: "
+            << character * 1e6 << " us/character, "
+            << enter * 1e6 << " us/enter or join, "
+            << word * 1e6 << " us/rewrapping word, "
+            << full * 1e3 << " ms full relayout" << endl;
+    }
+}
+
+void BenchmarkOnDemand(Renderer& renderer, Font& font)
+{
+    const int Frames = 200;
+
+    for (int onDemand = 0; onDemand < 2; onDemand++)
+    {
+        renderer.SetOnDemand(onDemand != 0);
+
+        // Idle frames repeat the same text, panned frames move it by a pixel each
+        for (int panned = 0; panned < 2; panned++)
+        {
+            size_t redraws = renderer.Redraws();
+
+            double seconds = Seconds([&]
+            {
+                for (int f = 0; f < Frames; f++)
+                {
+                    renderer.BeginFrame(800, 600);
+
+                    renderer.Push();
+                    renderer.Multiply(glm::translate(glm::vec3(panned ? (float)(f % 100) : 0.f, 0.f, 0.f)));
+                    renderer.Multiply(glm::scale(glm::vec3(4.f, 4.f, 1.f)));
+                    renderer.Print(font, -80, -10, "Hello world");
+                    renderer.Pop();
+
+                    renderer.EndFrame();
+                }
+
+                gl.Finish();
+            });
+
+            cout << (onDemand ? "On-demand " : "Continuous ") << (panned ? "panned" : "idle") << ": "
+                << seconds * 1e3 / Frames << " ms/frame, "
+                << renderer.Redraws() - redraws << " of " << Frames << " frames drawn" << endl;
+        }
+    }
+
+    renderer.SetOnDemand(false);
+}
+
+void BenchmarkBatch(Font& font)
+{
+    const size_t Count = 20000;
+
+    vector<string> strings = RandomStrings(Count, 4, 24);
+    vector<const char*> strs;
+
+    for (auto& s : strings)
+        strs.push_back(s.c_str());
+
+    Renderer renderer;
+
+    // A ring of one buffer waits for every readback before drawing the next frame
+    for (size_t ring = 1; ring <= 3; ring += 2)
+    {
+        BatchRasterizer rasterizer(renderer, font, 256, 32, 8, 64, ring);
+
+        size_t delivered = 0;
+        unsigned checksum = 0;
+
+        double seconds = Seconds([&]
+        {
+            rasterizer.Rasterize(strs.data(), Count, 0.75f, [&](size_t index, const unsigned char* pixels, GLsizei width, GLsizei height, GLsizei stride)
+            {
+                delivered++;
+                checksum += pixels[(height / 2) * stride + width * 3 / 2];
+            });
+        });
+
+        cout << "Batch rasterization, ring of " << ring << ": " << delivered / seconds << " strings/s (checksum " << checksum << ")" << endl;
+    }
+}
+
+void BenchmarkLod(Renderer& renderer, Font& font)
+{
+    const int Lines = 100;
+    const int Frames = 10;
+
+    vector<string> strings = RandomStrings(Lines, 80, 80);
+
+    auto frame = [&](float scale)
+    {
+        renderer.BeginFrame(800, 600);
+
+        renderer.Push();
+        renderer.Multiply(glm::translate(glm::vec3(-390.f, 290.f, 0.f)));
+        renderer.Multiply(glm::scale(glm::vec3(scale, scale, 1.f)));
+        for (int i = 0; i < Lines; i++)
+            renderer.Print(font, 0.f, -60.f * (i + 1), strings[i].c_str());
+        renderer.Pop();
+
+        renderer.EndFrame();
+    };
+
+    for (float scale = 8.f; scale >= 0.125f; scale *= 0.5f)
+    {
+        for (int lod = 1; lod >= 0; lod--)
+        {
+            font.SetPixelError(lod ? 0.25f : 0.f);
+
+            // The level depends on the size of the frame's target
+            renderer.BeginFrame(800, 600);
+            renderer.Push();
+            renderer.Multiply(glm::scale(glm::vec3(scale, scale, 1.f)));
+            int level = font.Level(renderer);
+            renderer.Pop();
+
+            // The same frame once more on the stand-in, only to count what it submits
+            UseRecordingGL();
+            RecordedGL().Reset();
+            frame(scale);
+            size_t vertices = RecordedGL().vertices;
+            UseNativeGL();
+
+            frame(scale);
+            gl.Finish();
+
+            double seconds = Seconds([&]
+            {
+                for (int f = 0; f < Frames; f++)
+                    frame(scale);
+
+                gl.Finish();
+            });
+
+            cout << "Scale " << scale << (lod ? ", level " : ", exact, level ") << level << ": "
+                << seconds * 1e3 / Frames << " ms/frame, " << vertices << " vertices" << endl;
+        }
+    }
+
+    font.SetPixelError(0.25f);
+}
+
+void BenchmarkScroll(Renderer& renderer, Font& font)
+{
+    const int Lines = 10000;
+    const float LineHeight = 30.f;
+    const int Frames = 100;
+
+    vector<string> strings = RandomStrings(Lines, 60, 60);
+
+    // Only the lines reaching the rectangle, as a long document would print them
+    auto content = [&](Renderer& renderer, const glm::vec4& rect)
+    {
+        int first = max((int)floor((280.f - rect.w) / LineHeight) - 1, 0);
+        int last = min((int)ceil((280.f - rect.y) / LineHeight) + 1, Lines - 1);
+
+        for (int i = first; i <= last; i++)
+            renderer.Print(font, -400.f, 280.f - LineHeight * i, strings[i].c_str());
+    };
+
+    ScrollView view(renderer);
+
+    // A diagonal drag back and forth by speed pixels a frame, redrawn from scratch or scrolled
+    for (float speed : { 1.f, 4.f, 16.f })
+    {
+        for (int scrolled = 0; scrolled < 2; scrolled++)
+        {
+            glm::vec2 offset(0.f, 0.f);
+
+            view.Invalidate();
+            view.Draw(800, 600, 1.f, offset, content);
+            gl.Finish();
+
+            size_t exposed = view.Exposed();
+
+            double seconds = Seconds([&]
+            {
+                for (int f = 0; f < Frames; f++)
+                {
+                    if (!scrolled)
+                        view.Invalidate();
+
+                    offset += glm::vec2(speed, -speed * 0.5f) * (f / 10 % 2 ? -1.f : 1.f);
+                    view.Draw(800, 600, 1.f, offset, content);
+                }
+
+                gl.Finish();
+            });
+
+            cout << (scrolled ? "Scrolled" : "Redrawn") << " pan by " << speed << " px: "
+                << seconds * 1e3 / Frames << " ms/frame, "
+                << (view.Exposed() - exposed) / Frames << " pixels exposed a frame" << endl;
+        }
+    }
+}
+
+static void Report(const char* name, double seconds, int repeats)
+{
+    const GLStats& stats = RecordedGL();
+
+    cout << name << ": " << seconds * 1e3 / repeats << " ms, "
+        << stats.Calls() / repeats << " calls, "
+        << stats.stateChanges / repeats << " state changes ("
+        << stats.redundantChanges / repeats << " redundant), "
+        << stats.uploaded / repeats << " bytes uploaded, "
+        << stats.draws / repeats << " draws of "
+        << stats.vertices / repeats << " vertices" << endl;
+}
+
+void BenchmarkRecorded(const char* filename)
+{
+    UseRecordingGL();
+
+    {
+        GLStats& stats = RecordedGL();
+
+        const int Loads = 20;
+
+        stats.Reset();
+        double load = Seconds([&]
+        {
+            for (int i = 0; i < Loads; i++)
+            {
+                Font font;
+                Load(font, filename, Printable);
+            }
+        });
+        Report("Recorded Load", load, Loads);
+
+        Font font;
+        Load(font, filename, Printable);
+
+        Renderer renderer;
+        renderer.BeginFrame(800, 600);
+
+        const float colors[6 * 4] = {};
+        const float samples[6 * 2] = {};
+
+        string text = RandomStrings(1, 100000, 100000)[0];
+
+        stats.Reset();
+        double print = Seconds([&]
+        {
+            font.Print(0.f, 0.f, text.c_str(), colors, samples, 6, renderer, Static, 0.f);
+        });
+        Report("Recorded Font::Print of 100000 characters", print, 1);
+
+        const int Prints = 10000;
+        vector<string> strings = RandomStrings(Prints, 4, 48);
+
+        stats.Reset();
+        double frame = Seconds([&]
+        {
+            renderer.BeginFrame(800, 600);
+
+            for (auto& s : strings)
+                renderer.Print(font, 0.f, 0.f, s.c_str());
+
+            renderer.EndFrame();
+        });
+        Report("Recorded frame of 10000 Renderer::Print", frame, 1);
+
+        // The same strings animated, which should cost no more on the CPU
+        const Animation wave = { Effect::Wave, 4.f, 6.f, 0.5f };
+
+        stats.Reset();
+        double animated = Seconds([&]
+        {
+            renderer.SetTime(1.f);
+            renderer.BeginFrame(800, 600);
+
+            for (auto& s : strings)
+                renderer.Print(font, 0.f, 0.f, s.c_str(), wave);
+
+            renderer.EndFrame();
+        });
+        Report("Recorded frame of 10000 animated Renderer::Print", animated, 1);
+
+        // A live resize, one pixel wider and taller every frame
+        const int Frames = 400;
+
+        stats.Reset();
+        double resize = Seconds([&]
+        {
+            for (int f = 0; f < Frames; f++)
+            {
+                renderer.BeginFrame(800 + f, 600 + f);
+                renderer.Print(font, 0.f, 0.f, "Hello world");
+                renderer.EndFrame();
+            }
+        });
+        cout << "Recorded live resize: " << (stats.calls[GLFunctionTexStorage2D] + stats.calls[GLFunctionTexImage2D]) / 2 << " reallocations in "
+            << Frames << " frames, " << resize * 1e3 / Frames << " ms/frame" << endl;
+
+        // Independent panes drawn from the same font and its buffers
+        stats.Reset();
+        double panes = Seconds([&]
+        {
+            for (size_t t = 1; t <= 4; t++)
+            {
+                renderer.BeginFrame(renderer.Target(t), 400, 300);
+                renderer.Print(font, 0.f, 0.f, strings[t].c_str());
+                renderer.EndFrame((GLint)(t - 1) % 2 * 400, (GLint)(t - 1) / 2 * 300);
+            }
+        });
+        Report("Recorded frame of 4 panes", panes, 1);
+    }
+
+    UseNativeGL();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+class Font;
+class Renderer;
+
+// Every printable ASCII character, for fonts loaded to be benchmarked
+extern const char* const Printable;
+
+// Loads the glyphs of str from a font file, with FreeType in TextTest.cpp
+void Load(Font& font, const char* filename, const char* str);
+
+// Runs without a context, on the recording GL stand-in
+void BenchmarkRecorded(const char* filename);
+
+void BenchmarkMeasure(Font& font);
+void BenchmarkLayout(Font& font);
+void BenchmarkOnDemand(Renderer& renderer, Font& font);
+void BenchmarkLod(Renderer& renderer, Font& font);
+void BenchmarkScroll(Renderer& renderer, Font& font);
+void BenchmarkBatch(Font& font);
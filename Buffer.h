@@ -1,6 +1,6 @@
 #pragma once
 
-#include <gl/glew.h>
+#include "GL.h"
 #include <vector>
 
 #define DEFINE_GL_ARRAY_HELPER(name, gen, del)                                 \
@@ -8,7 +8,7 @@
     name(size_t n) : std::vector<GLuint>(n) { gen(n, data()); }                \
     ~name() { del(size(), data()); }                                           \
   };
-DEFINE_GL_ARRAY_HELPER(Buffers, glGenBuffers, glDeleteBuffers)
-DEFINE_GL_ARRAY_HELPER(VertexArrays, glGenVertexArrays, glDeleteVertexArrays)
-DEFINE_GL_ARRAY_HELPER(Textures, glGenTextures, glDeleteTextures)
-DEFINE_GL_ARRAY_HELPER(Framebuffers, glGenFramebuffers, glDeleteFramebuffers)
+DEFINE_GL_ARRAY_HELPER(Buffers, gl.GenBuffers, gl.DeleteBuffers)
+DEFINE_GL_ARRAY_HELPER(VertexArrays, gl.GenVertexArrays, gl.DeleteVertexArrays)
+DEFINE_GL_ARRAY_HELPER(Textures, gl.GenTextures, gl.DeleteTextures)
+DEFINE_GL_ARRAY_HELPER(Framebuffers, gl.GenFramebuffers, gl.DeleteFramebuffers)
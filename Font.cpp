@@ -1,12 +1,19 @@
 #include "Font.h"
 #include "Renderer.h"
 #include <iostream>
+#include <cmath>
+#include <cfloat>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <glm/gtx/transform.hpp>
 
 constexpr int ProjectionLocation = 0;
 constexpr int ModelLocation = 1;
 constexpr int SamplesLocation = 2;
 constexpr int ColorsLocation = 3;
+constexpr int GlyphLocation = 4;
+constexpr int AnimationLocation = 5;
+constexpr int TimeLocation = 6;
 
 constexpr const char* VertexShader = R"shader(
 #version 410
@@ -20,9 +27,35 @@ uniform mat4 projection;
 uniform mat4 model;
 uniform vec2 samples[6];
 
+// Pen position, index and advance of the glyph
+uniform vec3 glyph;
+// Effect, amplitude, speed and phase, see Animation.h
+uniform vec4 animation;
+uniform float time;
+
+vec2 animate(vec2 point)
+{
+    int effect = int(animation.x);
+    float pen = glyph.x;
+
+    if (effect == 1)
+        point.y += animation.y * sin(animation.z * time + animation.w * glyph.y);
+    else if (effect == 2)
+        point *= step(glyph.y, animation.z * time);
+    else if (effect == 3)
+        pen = mod(pen - animation.z * time, animation.y);
+    else if (effect == 4)
+    {
+        vec2 center = vec2(glyph.z * 0.5, 0.);
+        point = center + (point - center) * clamp(animation.z * (time - animation.w * glyph.y), 0., 1.);
+    }
+
+    return vec2(pen, 0.) + point;
+}
+
 void main()
 {
-    vec4 pos = model * vec4(position.xy, 0., 1.);
+    vec4 pos = model * vec4(animate(position.xy), 0., 1.);
     pos.xy += samples[gl_InstanceID];
     gl_Position = projection * pos;
     polar.xy = position.zw;
@@ -66,85 +99,330 @@ void main()
 #define triangleBuffer (buffers[1])
 #define fanBuffer (buffers[2])
 
-Font::Font() :
-    buffers(3)
+const glm::vec4 EmptyBounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+inline float Cross(glm::vec2 a, glm::vec2 b, glm::vec2 c)
+{
+    return ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) * 0.5f;
+}
+
+// Area of the triangle fan of a contour around the anchor: signed, it is the
+// contour area whatever the anchor is; unsigned, it is what gets rasterized.
+static float FanArea(const vector<glm::vec4>& points, const GLushort* indices, GLushort length, glm::vec2 anchor, bool absolute)
+{
+    float area = 0.f;
+
+    for (GLushort i = 2; i < length; i++)
+    {
+        const glm::vec4& b = points[indices[i - 1]];
+        const glm::vec4& c = points[indices[i]];
+
+        float a = Cross(anchor, glm::vec2(b.x, b.y), glm::vec2(c.x, c.y));
+        area += absolute ? abs(a) : a;
+    }
+
+    return area;
+}
+
+static float Distance(glm::vec2 p, glm::vec2 a, glm::vec2 b)
+{
+    glm::vec2 ab = b - a;
+    float length = glm::dot(ab, ab);
+    float t = length > 0.f ? glm::clamp(glm::dot(p - a, ab) / length, 0.f, 1.f) : 0.f;
+
+    return glm::distance(p, a + ab * t);
+}
+
+// Drops curves bulging less than half the error from their chord, then line
+// points less than half the error from the line replacing them. A dropped
+// curve lies within half the error of its chord, whose ends lie within half
+// the error of the new line, so the result strays less than the error.
+static vector<OutlinePoint> Simplify(const vector<OutlinePoint>& contour, float error)
+{
+    vector<OutlinePoint> result(1, contour[0]);
+    vector<glm::vec2> run;
+
+    auto flush = [&]()
+    {
+        if (!run.empty())
+            result.push_back({ run.back(), false });
+        run.clear();
+    };
+
+    for (size_t i = 1; i < contour.size(); i++)
+    {
+        glm::vec2 end = contour[i].position;
+
+        if (contour[i].control)
+        {
+            end = contour[++i].position;
+
+            glm::vec2 start = run.empty() ? result.back().position : run.back();
+            glm::vec2 control = contour[i - 1].position;
+
+            if (glm::distance(control, (start + end) * 0.5f) * 0.5f > error * 0.5f)
+            {
+                flush();
+                result.push_back(contour[i - 1]);
+                result.push_back(contour[i]);
+                continue;
+            }
+        }
+
+        glm::vec2 start = result.back().position;
+
+        for (auto& p : run)
+            if (Distance(p, start, end) > error * 0.5f)
+            {
+                flush();
+                break;
+            }
+
+        run.push_back(end);
+    }
+
+    flush();
+
+    return result;
+}
+
+Font::Font(FanAnchor anchor) :
+    buffers(3),
+    anchor(anchor),
+    rasterizedArea(0.f),
+    coveredArea(0.f),
+    em(1.f),
+    pixelError(0.25f)
 {
-    Shader vertex(GL_VERTEX_SHADER), simple(GL_FRAGMENT_SHADER), bezier(GL_FRAGMENT_SHADER);
+    advances.fill(0.f);
+    bounds.fill(EmptyBounds);
+
+    // Both programs share the vertex shader
+    ShaderCache shaders;
 
-    if (!vertex.Compile(VertexShader) ||
-        !simple.Compile(SimpleShader) ||
-        !bezier.Compile(BezierShader) ||
-        !simpleProgram.Link(vertex, simple) ||
-        !bezierProgram.Link(vertex, bezier))
+    if (!simpleProgram.Build(VertexShader, SimpleShader, shaders) ||
+        !bezierProgram.Build(VertexShader, BezierShader, shaders))
         exit(-1);
 
-    simpleProgram.PrepareLocations({"projection", "model", "samples", "colors"});
-    bezierProgram.PrepareLocations({"projection", "model", "samples", "colors"});
+    simpleProgram.PrepareLocations({"projection", "model", "samples", "colors", "glyph", "animation", "time"});
+    bezierProgram.PrepareLocations({"projection", "model", "samples", "colors", "glyph", "animation", "time"});
 }
 
 Font::~Font()
 {
 }
 
-void Font::AddContour(Glyph& glyph, float x, float y, float t, DrawParams& params)
+void Font::CloseContour(GlyphMesh& mesh, DrawParams& params)
 {
-    GLushort index = (GLushort)points.size();
-    GLushort fan_size = (GLushort)fan.size();
+    params.length = (GLushort)fan.size() - params.start;
+    if (params.length <= 2)
+        return;
 
-    params.length = fan_size - params.start;
-    if (params.length > 2)
-        glyph.fans.push_back(params);
-    params.start = fan_size;
+    PlaceAnchor(params);
+    mesh.fans.push_back(params);
+}
 
-    fan.push_back(index);
-    fan.push_back(index + 1);
+void Font::PlaceAnchor(const DrawParams& params)
+{
+    const GLushort* indices = &fan[params.start];
+    glm::vec4& point = points[indices[0]];
 
-    points.push_back({ 0.f, 0.f, 0.f, 0.f });
-    points.push_back({ x, y, t, 0.f });
+    glm::vec2 low(points[indices[1]].x, points[indices[1]].y);
+    glm::vec2 high = low;
+    glm::vec2 sum(0.f, 0.f);
+
+    for (GLushort i = 1; i < params.length; i++)
+    {
+        glm::vec2 p(points[indices[i]].x, points[indices[i]].y);
+        low = glm::min(low, p);
+        high = glm::max(high, p);
+        sum += p;
+    }
+
+    glm::vec2 centroid = sum / (float)(params.length - 1);
+    glm::vec2 center = (low + high) * 0.5f;
+    glm::vec2 best(0.f, 0.f);
+
+    switch (anchor)
+    {
+    case FanAnchor::Origin:
+        break;
+    case FanAnchor::Centroid:
+        best = centroid;
+        break;
+    case FanAnchor::BoundsCenter:
+        best = center;
+        break;
+    case FanAnchor::Best:
+    {
+        // A contour vertex gives a convex contour zero overdraw, so try them all
+        float area = FanArea(points, indices, params.length, best, true);
+
+        auto consider = [&](glm::vec2 candidate)
+        {
+            float a = FanArea(points, indices, params.length, candidate, true);
+            if (a < area)
+            {
+                area = a;
+                best = candidate;
+            }
+        };
+
+        consider(centroid);
+        consider(center);
+        for (GLushort i = 1; i < params.length; i++)
+            consider(glm::vec2(points[indices[i]].x, points[indices[i]].y));
+        break;
+    }
+    }
+
+    point.x = best.x;
+    point.y = best.y;
 }
 
-void Font::AddLine(Glyph& glyph, float x, float y, float t)
+void Font::AddContour(float x, float y)
 {
-    GLushort index = (GLushort)points.size();
+    contours.emplace_back();
+    contours.back().push_back({ glm::vec2(x, y), false });
+}
 
-    fan.push_back(index);
+void Font::AddLine(float x, float y)
+{
+    contours.back().push_back({ glm::vec2(x, y), false });
+}
 
-    points.push_back({ x, y, t, 0.f });
+void Font::AddCurve(float px, float py, float x, float y)
+{
+    contours.back().push_back({ glm::vec2(px, py), true });
+    contours.back().push_back({ glm::vec2(x, y), false });
 }
 
-void Font::AddCurve(Glyph& glyph, float px, float py, float x, float y, float t)
+void Font::EmitContour(GlyphMesh& mesh, const vector<OutlinePoint>& contour)
 {
     GLushort index = (GLushort)points.size();
 
-    points.push_back({ px, py, 0.f, 1.f });
-    points.push_back({ x, y, t, 0.f });
+    DrawParams params;
+    params.start = (GLushort)fan.size();
 
+    fan.push_back(index);
     fan.push_back(index + 1);
 
-    triangles.push_back(index - 1);
-    triangles.push_back(index);
-    triangles.push_back(index + 1);
+    points.push_back({ 0.f, 0.f, 0.f, 0.f });
+    points.push_back({ contour[0].position.x, contour[0].position.y, 0.f, 0.f });
+
+    // Consecutive points alternate t, so every curve runs from 0 to 1 or back
+    float t = 0.f;
+
+    for (size_t i = 1; i < contour.size(); i++)
+    {
+        index = (GLushort)points.size();
+        t = 1.f - t;
+
+        if (contour[i].control)
+        {
+            const glm::vec2& p = contour[i].position;
+            const glm::vec2& e = contour[++i].position;
+
+            points.push_back({ p.x, p.y, 0.f, 1.f });
+            points.push_back({ e.x, e.y, t, 0.f });
+
+            fan.push_back(index + 1);
+
+            triangles.push_back(index - 1);
+            triangles.push_back(index);
+            triangles.push_back(index + 1);
+        }
+        else
+        {
+            fan.push_back(index);
+
+            points.push_back({ contour[i].position.x, contour[i].position.y, t, 0.f });
+        }
+    }
+
+    CloseContour(mesh, params);
 }
 
-void Font::FinishGlyph(Glyph& glyph, DrawParams& params)
+void Font::FinishGlyph(Glyph& glyph)
 {
-    GLushort fan_size = (GLushort)fan.size();
-    params.length = fan_size - params.start;
-    if (params.length > 2)
-        glyph.fans.push_back(params);
+    vector<vector<OutlinePoint>> previous;
+
+    for (int level = 0; level < LevelCount; level++)
+    {
+        GlyphMesh& mesh = glyph.levels[level];
+
+        vector<vector<OutlinePoint>> simplified;
+
+        for (auto& c : contours)
+            simplified.push_back(level > 0 ? Simplify(c, LevelErrors[level] * em) : c);
+
+        // A level simplifying nothing more draws the previous one's mesh
+        if (level > 0 && simplified == previous)
+        {
+            mesh = glyph.levels[level - 1];
+            continue;
+        }
+
+        mesh.triangles.start = (GLushort)triangles.size();
+
+        for (auto& c : simplified)
+            EmitContour(mesh, c);
+
+        mesh.triangles.length = (GLushort)triangles.size() - mesh.triangles.start;
+
+        previous.swap(simplified);
+    }
+
+    contours.clear();
+
+    // Bounds and overdraw are those of the exact outline
+    const GlyphMesh& mesh = glyph.levels[0];
+
+    // Control points bound the curves, so the bounds of all points bound the ink
+    glyph.bounds = EmptyBounds;
+
+    auto grow = [&](const glm::vec4& p)
+    {
+        glyph.bounds = glm::vec4(
+            glm::min(glm::vec2(glyph.bounds.x, glyph.bounds.y), glm::vec2(p.x, p.y)),
+            glm::max(glm::vec2(glyph.bounds.z, glyph.bounds.w), glm::vec2(p.x, p.y)));
+    };
+
+    for (auto& f : mesh.fans)
+        for (GLushort i = 1; i < f.length; i++)
+            grow(points[fan[f.start + i]]);
+
+    for (GLushort i = 0; i < mesh.triangles.length; i++)
+        grow(points[triangles[mesh.triangles.start + i]]);
+
+    // Ink area is the signed outline area, where each curve adds or removes 2/3 of its triangle
+    float covered = 0.f;
+
+    for (auto& f : mesh.fans)
+    {
+        glm::vec2 center(points[fan[f.start]].x, points[fan[f.start]].y);
 
-    glyph.triangles.length = (GLushort)triangles.size() - glyph.triangles.start;
+        rasterizedArea += FanArea(points, &fan[f.start], f.length, center, true);
+        covered += FanArea(points, &fan[f.start], f.length, center, false);
+    }
+
+    for (GLushort i = 0; i < mesh.triangles.length; i += 3)
+    {
+        const GLushort* t = &triangles[mesh.triangles.start + i];
+        float a = Cross(glm::vec2(points[t[0]].x, points[t[0]].y), glm::vec2(points[t[1]].x, points[t[1]].y), glm::vec2(points[t[2]].x, points[t[2]].y));
+
+        rasterizedArea += abs(a);
+        covered += a * (2.f / 3.f);
+    }
+
+    coveredArea += abs(covered);
 }
 
-Glyph& Font::CreateGlyph(const char c, GLfloat advance, DrawParams& params)
+Glyph& Font::CreateGlyph(const char c, GLfloat advance)
 {
     Glyph& glyph = glyphs[c];
 
     glyph.advance = advance;
-    glyph.triangles.start = (GLushort)triangles.size();
-
-    params.start = (GLushort)fan.size();
-    params.length = 0;
 
     return glyph;
 }
@@ -156,81 +434,140 @@ const bool Font::HasGlyph(const char c) const
 
 void Font::FillBuffers()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec4), &points[0], GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    gl.BufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec4), &points[0], GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangleBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size() * sizeof(GLushort), &triangles[0], GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangleBuffer);
+    gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size() * sizeof(GLushort), &triangles[0], GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, fanBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, fan.size() * sizeof(GLushort), &fan[0], GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, fanBuffer);
+    gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, fan.size() * sizeof(GLushort), &fan[0], GL_STATIC_DRAW);
 
     points.clear();
     triangles.clear();
     fan.clear();
+
+    for (auto& g : glyphs)
+    {
+        advances[(unsigned char)g.first] = g.second.advance;
+        bounds[(unsigned char)g.first] = g.second.bounds;
+    }
 }
 
-void Font::Print(float x, float y, const char* str, const float* colors, const float* samples, GLsizei count, Renderer& renderer)
+GLfloat Font::Advance(const char* str) const
 {
+    const unsigned char* s = (const unsigned char*)str;
     size_t len = strlen(str);
+    size_t i = 0;
 
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    // Independent partial sums, so additions don't wait on each other
+    GLfloat sum[4] = { 0.f, 0.f, 0.f, 0.f };
 
-    glVertexPointer(4, GL_FLOAT, sizeof(glm::vec4), 0);
+    for (; i + 4 <= len; i += 4)
+    {
+        sum[0] += advances[s[i + 0]];
+        sum[1] += advances[s[i + 1]];
+        sum[2] += advances[s[i + 2]];
+        sum[3] += advances[s[i + 3]];
+    }
 
-    glUseProgram(bezierProgram);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, triangleBuffer);
+    for (; i < len; i++)
+        sum[0] += advances[s[i]];
 
-    glUniformMatrix4fv(bezierProgram[ProjectionLocation], 1, GL_FALSE , &renderer.Projection()[0][0]);
-    glUniform4fv(bezierProgram[ColorsLocation], count, colors);
-    glUniform2fv(bezierProgram[SamplesLocation], count, samples);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
 
-    renderer.Push();
-    renderer.Multiply(glm::translate(glm::vec3(x, y, 0.f)));
+TextMetrics Font::Measure(const char* str) const
+{
+    const unsigned char* s = (const unsigned char*)str;
 
-    renderer.Push();
+    GLfloat pen = 0.f;
+    glm::vec4 ink = EmptyBounds;
 
-    for (size_t i = 0; i < len; i++)
+    for (; *s; s++)
     {
-        if (!HasGlyph(str[i]))
-            continue;
+        const glm::vec4& b = bounds[*s];
 
-        glUniformMatrix4fv(bezierProgram[ModelLocation], 1, GL_FALSE, &renderer.Model()[0][0]);
+        ink = glm::vec4(
+            glm::min(glm::vec2(ink.x, ink.y), glm::vec2(pen + b.x, b.y)),
+            glm::max(glm::vec2(ink.z, ink.w), glm::vec2(pen + b.z, b.w)));
 
-        Glyph& g = glyphs[str[i]];
+        pen += advances[*s];
+    }
 
-        if (g.triangles.length > 0)
-            glDrawElementsInstanced(GL_TRIANGLES, g.triangles.length, GL_UNSIGNED_SHORT, (void*)(g.triangles.start * sizeof(GLushort)), count);
+    if (ink.x > ink.z)
+        ink = glm::vec4(0.f, 0.f, 0.f, 0.f);
 
-        renderer.Multiply(glm::translate(glm::vec3(g.advance, 0.f, 0.f)));
-    }
+    return { pen, ink };
+}
 
-    renderer.Pop();
+void Font::Measure(const char* const* strs, size_t count, TextMetrics* metrics) const
+{
+    for (size_t i = 0; i < count; i++)
+        metrics[i] = Measure(strs[i]);
+}
 
-    glUseProgram(simpleProgram);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, fanBuffer);
+int Font::Level(const Renderer& renderer) const
+{
+    float scale = renderer.PixelScale();
+    int level = 0;
 
-    glUniformMatrix4fv(simpleProgram[ProjectionLocation], 1, GL_FALSE, &renderer.Projection()[0][0]);
-    glUniform4fv(simpleProgram[ColorsLocation], count, colors);
-    glUniform2fv(simpleProgram[SamplesLocation], count, samples);
+    while (level + 1 < LevelCount && LevelErrors[level + 1] * em * scale <= pixelError)
+        level++;
 
-    renderer.Push();
+    return level;
+}
 
-    for (size_t i = 0; i < len; i++)
-    {
-        if (!HasGlyph(str[i]))
-            continue;
+void Font::Print(float x, float y, const char* str, const float* colors, const float* samples, GLsizei count, Renderer& renderer, const Animation& animation, float time)
+{
+    size_t len = strlen(str);
+    int level = Level(renderer);
 
-        glUniformMatrix4fv(simpleProgram[ModelLocation], 1, GL_FALSE, &renderer.Model()[0][0]);
+    // Glyphs are placed by the shader, so the model is the same for the whole string
+    glm::mat4 model = renderer.Model() * glm::translate(glm::vec3(x, y, 0.f));
 
-        Glyph& g = glyphs[str[i]];
+    gl.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
 
-        for (auto& f : g.fans)
-            glDrawElementsInstanced(GL_TRIANGLE_FAN, f.length, GL_UNSIGNED_SHORT, (void*)(f.start * sizeof(GLushort)), count);
+    gl.VertexPointer(4, GL_FLOAT, sizeof(glm::vec4), 0);
 
-        renderer.Multiply(glm::translate(glm::vec3(g.advance, 0.f, 0.f)));
+    for (int pass = 0; pass < 2; pass++)
+    {
+        Program& program = pass ? simpleProgram : bezierProgram;
+
+        gl.UseProgram(program);
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, pass ? fanBuffer : triangleBuffer);
+
+        gl.UniformMatrix4fv(program[ProjectionLocation], 1, GL_FALSE, &renderer.Projection()[0][0]);
+        gl.UniformMatrix4fv(program[ModelLocation], 1, GL_FALSE, &model[0][0]);
+        gl.Uniform4fv(program[ColorsLocation], count, colors);
+        gl.Uniform2fv(program[SamplesLocation], count, samples);
+        gl.Uniform4f(program[AnimationLocation], (GLfloat)animation.effect, animation.amplitude, animation.speed, animation.phase);
+        gl.Uniform1f(program[TimeLocation], time);
+
+        GLfloat pen = 0.f;
+
+        for (size_t i = 0; i < len; i++)
+        {
+            if (!HasGlyph(str[i]))
+                continue;
+
+            Glyph& g = glyphs[str[i]];
+            GlyphMesh& mesh = g.levels[level];
+
+            gl.Uniform3f(program[GlyphLocation], pen, (GLfloat)i, g.advance);
+
+            if (pass == 0)
+            {
+                if (mesh.triangles.length > 0)
+                    gl.DrawElementsInstanced(GL_TRIANGLES, mesh.triangles.length, GL_UNSIGNED_SHORT, (void*)(mesh.triangles.start * sizeof(GLushort)), count);
+            }
+            else
+            {
+                for (auto& f : mesh.fans)
+                    gl.DrawElementsInstanced(GL_TRIANGLE_FAN, f.length, GL_UNSIGNED_SHORT, (void*)(f.start * sizeof(GLushort)), count);
+            }
+
+            pen += g.advance;
+        }
     }
-
-    renderer.Pop();
-    renderer.Pop();
 }
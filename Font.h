@@ -1,8 +1,10 @@
 #pragma once
 
+#include "Animation.h"
 #include "Program.h"
 #include "Buffer.h"
 #include <map>
+#include <array>
 #include <glm/mat4x4.hpp>
 
 using namespace std;
@@ -13,12 +15,50 @@ struct DrawParams
     GLushort length;
 };
 
-struct Glyph
+struct GlyphMesh
 {
     vector<DrawParams> fans;
     DrawParams triangles;
+};
+
+// Outline simplification levels, by how far each may stray from the exact outline in ems
+constexpr int LevelCount = 4;
+constexpr GLfloat LevelErrors[LevelCount] = { 0.f, 1.f / 64.f, 1.f / 32.f, 1.f / 16.f };
+
+struct Glyph
+{
+    GlyphMesh levels[LevelCount];
 
     GLfloat advance;
+    glm::vec4 bounds;
+};
+
+struct OutlinePoint
+{
+    glm::vec2 position;
+    bool control;
+
+    bool operator==(const OutlinePoint& other) const
+    {
+        return position == other.position && control == other.control;
+    }
+};
+
+struct TextMetrics
+{
+    GLfloat advance;
+    // Ink box as left, bottom, right, top, relative to the pen origin
+    glm::vec4 bounds;
+};
+
+// Where each contour's triangle fan is anchored. Any anchor gives the same
+// even-odd coverage, but a poorly placed one rasterizes the same pixels many times.
+enum class FanAnchor
+{
+    Origin,
+    Centroid,
+    BoundsCenter,
+    Best,
 };
 
 class Renderer;
@@ -32,24 +72,74 @@ class Font
     vector<GLushort> fan;
     vector<GLushort> triangles;
 
+    // Contours of the glyph being loaded, meshed for every level once it's finished
+    vector<vector<OutlinePoint>> contours;
+
+    // Indexed by unsigned char, filled once by FillBuffers for measurement
+    array<GLfloat, 256> advances;
+    array<glm::vec4, 256> bounds;
+
     Buffers buffers;
     
     Program simpleProgram;
     Program bezierProgram;
+
+    FanAnchor anchor;
+
+    float rasterizedArea;
+    float coveredArea;
+
+    GLfloat em;
+    GLfloat pixelError;
+
+    void EmitContour(GlyphMesh& mesh, const vector<OutlinePoint>& contour);
+    void CloseContour(GlyphMesh& mesh, DrawParams& params);
+    void PlaceAnchor(const DrawParams& params);
 public:
-    Font();
+    Font(FanAnchor anchor = FanAnchor::Best);
     ~Font();
 
-    void AddContour(Glyph& glyph, float x, float y, float t, DrawParams& params);
-    void AddLine(Glyph& glyph, float x, float y, float t);
-    void AddCurve(Glyph& glyph, float px, float py, float x, float y, float t);
+    // Size of the em in outline units, which simplification errors are relative to
+    void SetEm(GLfloat em)
+    {
+        Font::em = em;
+    }
+
+    void AddContour(float x, float y);
+    void AddLine(float x, float y);
+    void AddCurve(float px, float py, float x, float y);
 
-    Glyph& CreateGlyph(const char c, GLfloat advance, DrawParams& params);
-    void FinishGlyph(Glyph& glyph, DrawParams& params);
+    Glyph& CreateGlyph(const char c, GLfloat advance);
+    void FinishGlyph(Glyph& glyph);
 
     const bool HasGlyph(const char c) const;
 
+    // Pixels rasterized per covered pixel by the loaded glyphs, instancing aside
+    float Overdraw() const
+    {
+        return coveredArea > 0.f ? rasterizedArea / coveredArea : 0.f;
+    }
+
     void FillBuffers();
 
-    void Print(float x, float y, const char* str, const float* colors, const float* samples, GLsizei count, Renderer& renderer);
+    // Measurement only reads tables which are immutable after FillBuffers,
+    // so it needs no GL context and is safe to call from any thread
+    GLfloat Advance(const char c) const
+    {
+        return advances[(unsigned char)c];
+    }
+
+    GLfloat Advance(const char* str) const;
+    TextMetrics Measure(const char* str) const;
+    void Measure(const char* const* strs, size_t count, TextMetrics* metrics) const;
+
+    // Print draws the coarsest level which strays less than this many pixels, zero draws exact outlines
+    void SetPixelError(GLfloat pixelError)
+    {
+        Font::pixelError = pixelError;
+    }
+
+    int Level(const Renderer& renderer) const;
+
+    void Print(float x, float y, const char* str, const float* colors, const float* samples, GLsizei count, Renderer& renderer, const Animation& animation, float time);
 };
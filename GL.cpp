@@ -0,0 +1,349 @@
+#include "GL.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+#define GL_NATIVE(ret, name, params, args) static ret GLAPIENTRY Native##name params { return gl##name args; }
+GL_FUNCTIONS(GL_NATIVE)
+
+#define GL_NATIVE_ENTRY(ret, name, params, args) &Native##name,
+#define GL_NAME(ret, name, params, args) "gl" #name,
+
+GLDispatch gl = { GL_FUNCTIONS(GL_NATIVE_ENTRY) };
+
+const char* const GLFunctionNames[GLFunctionCount] = { GL_FUNCTIONS(GL_NAME) };
+
+size_t GLStats::Calls() const
+{
+    size_t sum = 0;
+    for (auto c : calls)
+        sum += c;
+    return sum;
+}
+
+void GLStats::Reset()
+{
+    *this = GLStats();
+}
+
+static GLStats stats;
+
+// Last values given to each state setter, keyed by function and target
+static map<pair<GLFunction, GLenum>, vector<GLint>> state;
+
+static GLuint names;
+static vector<unsigned char> mapped;
+
+static void Change(GLFunction function, GLenum key, initializer_list<GLint> value)
+{
+    auto& current = state[make_pair(function, key)];
+
+    if (current.size() == value.size() && equal(value.begin(), value.end(), current.begin()))
+        stats.redundantChanges++;
+    else
+        current.assign(value);
+
+    stats.stateChanges++;
+}
+
+template<typename T>
+static T Nothing()
+{
+    return T();
+}
+
+// Counts the call and returns zero, for everything not recorded more closely below
+#define GL_COUNT(ret, name, params, args) static ret GLAPIENTRY Count##name params { stats.calls[GLFunction##name]++; return Nothing<ret>(); }
+GL_FUNCTIONS(GL_COUNT)
+
+#define GL_COUNT_ENTRY(ret, name, params, args) &Count##name,
+
+static const GLDispatch counting = { GL_FUNCTIONS(GL_COUNT_ENTRY) };
+
+#define COUNT(name) stats.calls[GLFunction##name]++
+
+static void GLAPIENTRY Generate(GLsizei n, GLuint* ids)
+{
+    for (GLsizei i = 0; i < n; i++)
+        ids[i] = ++names;
+}
+
+#define GL_RECORD_GEN(name) static void GLAPIENTRY Record##name(GLsizei n, GLuint* ids) { COUNT(name); Generate(n, ids); }
+GL_RECORD_GEN(GenBuffers)
+GL_RECORD_GEN(GenFramebuffers)
+GL_RECORD_GEN(GenTextures)
+GL_RECORD_GEN(GenVertexArrays)
+
+static GLuint GLAPIENTRY RecordCreateProgram()
+{
+    COUNT(CreateProgram);
+    return ++names;
+}
+
+static GLuint GLAPIENTRY RecordCreateShader(GLenum type)
+{
+    COUNT(CreateShader);
+    return ++names;
+}
+
+// Everything compiles, links and validates, and no program binary is available
+static void GLAPIENTRY RecordGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+    COUNT(GetProgramiv);
+    *params = pname == GL_PROGRAM_BINARY_LENGTH ? 0 : GL_TRUE;
+}
+
+static void GLAPIENTRY RecordGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+    COUNT(GetShaderiv);
+    *params = GL_TRUE;
+}
+
+static void GLAPIENTRY RecordGetIntegerv(GLenum pname, GLint* data)
+{
+    COUNT(GetIntegerv);
+    *data = 0;
+}
+
+static const GLubyte* GLAPIENTRY RecordGetString(GLenum name)
+{
+    COUNT(GetString);
+    return (const GLubyte*)"Recording";
+}
+
+static GLenum GLAPIENTRY RecordCheckFramebufferStatus(GLenum target)
+{
+    COUNT(CheckFramebufferStatus);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLsync GLAPIENTRY RecordFenceSync(GLenum condition, GLbitfield flags)
+{
+    COUNT(FenceSync);
+    return (GLsync)&stats;
+}
+
+static GLenum GLAPIENTRY RecordClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+    COUNT(ClientWaitSync);
+    return GL_ALREADY_SIGNALED;
+}
+
+static void* GLAPIENTRY RecordMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    COUNT(MapBufferRange);
+    mapped.resize(length);
+    return mapped.data();
+}
+
+static GLboolean GLAPIENTRY RecordUnmapBuffer(GLenum target)
+{
+    COUNT(UnmapBuffer);
+    return GL_TRUE;
+}
+
+static void GLAPIENTRY RecordBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    COUNT(BufferData);
+    stats.uploaded += data ? size : 0;
+}
+
+static void GLAPIENTRY RecordShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+    COUNT(ShaderSource);
+    for (GLsizei i = 0; i < count; i++)
+        stats.uploaded += length ? length[i] : strlen(string[i]);
+}
+
+static void GLAPIENTRY RecordProgramUniform1f(GLuint program, GLint location, GLfloat v0)
+{
+    COUNT(ProgramUniform1f);
+    stats.uploaded += sizeof(v0);
+}
+
+static void GLAPIENTRY RecordProgramUniform1i(GLuint program, GLint location, GLint v0)
+{
+    COUNT(ProgramUniform1i);
+    stats.uploaded += sizeof(v0);
+}
+
+static void GLAPIENTRY RecordProgramUniform2f(GLuint program, GLint location, GLfloat v0, GLfloat v1)
+{
+    COUNT(ProgramUniform2f);
+    stats.uploaded += 2 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordProgramUniform4f(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+    COUNT(ProgramUniform4f);
+    stats.uploaded += 4 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordUniform1f(GLint location, GLfloat v0)
+{
+    COUNT(Uniform1f);
+    stats.uploaded += sizeof(v0);
+}
+
+static void GLAPIENTRY RecordUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    COUNT(Uniform2fv);
+    stats.uploaded += count * 2 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+    COUNT(Uniform3f);
+    stats.uploaded += 3 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+    COUNT(Uniform4f);
+    stats.uploaded += 4 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+    COUNT(Uniform4fv);
+    stats.uploaded += count * 4 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+    COUNT(UniformMatrix4fv);
+    stats.uploaded += count * 16 * sizeof(GLfloat);
+}
+
+static void GLAPIENTRY RecordDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    COUNT(DrawArrays);
+    stats.draws++;
+    stats.vertices += count;
+}
+
+static void GLAPIENTRY RecordDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount)
+{
+    COUNT(DrawElementsInstanced);
+    stats.draws++;
+    stats.vertices += (size_t)count * instancecount;
+}
+
+static void GLAPIENTRY RecordBindBuffer(GLenum target, GLuint buffer)
+{
+    COUNT(BindBuffer);
+    Change(GLFunctionBindBuffer, target, { (GLint)buffer });
+}
+
+static void GLAPIENTRY RecordBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    COUNT(BindFramebuffer);
+
+    if (target != GL_DRAW_FRAMEBUFFER)
+        Change(GLFunctionBindFramebuffer, GL_READ_FRAMEBUFFER, { (GLint)framebuffer });
+    if (target != GL_READ_FRAMEBUFFER)
+        Change(GLFunctionBindFramebuffer, GL_DRAW_FRAMEBUFFER, { (GLint)framebuffer });
+}
+
+static void GLAPIENTRY RecordBindTexture(GLenum target, GLuint texture)
+{
+    COUNT(BindTexture);
+    Change(GLFunctionBindTexture, target, { (GLint)texture });
+}
+
+static void GLAPIENTRY RecordUseProgram(GLuint program)
+{
+    COUNT(UseProgram);
+    Change(GLFunctionUseProgram, 0, { (GLint)program });
+}
+
+static void GLAPIENTRY RecordEnable(GLenum cap)
+{
+    COUNT(Enable);
+    Change(GLFunctionEnable, cap, { GL_TRUE });
+}
+
+static void GLAPIENTRY RecordDisable(GLenum cap)
+{
+    COUNT(Disable);
+    Change(GLFunctionEnable, cap, { GL_FALSE });
+}
+
+static void GLAPIENTRY RecordBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    COUNT(BlendFunc);
+    Change(GLFunctionBlendFunc, 0, { (GLint)sfactor, (GLint)dfactor });
+}
+
+static void GLAPIENTRY RecordViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    COUNT(Viewport);
+    Change(GLFunctionViewport, 0, { x, y, width, height });
+}
+
+static void GLAPIENTRY RecordVertexPointer(GLint size, GLenum type, GLsizei stride, const void* pointer)
+{
+    COUNT(VertexPointer);
+    Change(GLFunctionVertexPointer, 0, { size, (GLint)type, stride, (GLint)(size_t)pointer });
+}
+
+void UseNativeGL()
+{
+    gl = { GL_FUNCTIONS(GL_NATIVE_ENTRY) };
+}
+
+void UseRecordingGL()
+{
+    gl = counting;
+
+#define RECORD(name) gl.name = &Record##name
+    RECORD(GenBuffers);
+    RECORD(GenFramebuffers);
+    RECORD(GenTextures);
+    RECORD(GenVertexArrays);
+    RECORD(CreateProgram);
+    RECORD(CreateShader);
+    RECORD(GetProgramiv);
+    RECORD(GetShaderiv);
+    RECORD(GetIntegerv);
+    RECORD(GetString);
+    RECORD(CheckFramebufferStatus);
+    RECORD(FenceSync);
+    RECORD(ClientWaitSync);
+    RECORD(MapBufferRange);
+    RECORD(UnmapBuffer);
+    RECORD(BufferData);
+    RECORD(ShaderSource);
+    RECORD(ProgramUniform1f);
+    RECORD(ProgramUniform1i);
+    RECORD(ProgramUniform2f);
+    RECORD(ProgramUniform4f);
+    RECORD(Uniform1f);
+    RECORD(Uniform2fv);
+    RECORD(Uniform3f);
+    RECORD(Uniform4f);
+    RECORD(Uniform4fv);
+    RECORD(UniformMatrix4fv);
+    RECORD(DrawArrays);
+    RECORD(DrawElementsInstanced);
+    RECORD(BindBuffer);
+    RECORD(BindFramebuffer);
+    RECORD(BindTexture);
+    RECORD(UseProgram);
+    RECORD(Enable);
+    RECORD(Disable);
+    RECORD(BlendFunc);
+    RECORD(Viewport);
+    RECORD(VertexPointer);
+#undef RECORD
+
+    state.clear();
+}
+
+GLStats& RecordedGL()
+{
+    return stats;
+}
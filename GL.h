@@ -0,0 +1,123 @@
+#pragma once
+
+#include <gl/glew.h>
+#include <cstddef>
+
+// Every GL function called outside of glewInit, as X(return type, name, parameters, arguments)
+#define GL_FUNCTIONS(X) \
+    X(void, AttachShader, (GLuint program, GLuint shader), (program, shader)) \
+    X(void, BindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+    X(void, BindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+    X(void, BindTexture, (GLenum target, GLuint texture), (target, texture)) \
+    X(void, BlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+    X(void, BlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter)) \
+    X(void, BufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage)) \
+    X(GLenum, CheckFramebufferStatus, (GLenum target), (target)) \
+    X(void, Clear, (GLbitfield mask), (mask)) \
+    X(void, ClearColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha)) \
+    X(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+    X(void, CompileShader, (GLuint shader), (shader)) \
+    X(GLuint, CreateProgram, (), ()) \
+    X(GLuint, CreateShader, (GLenum type), (type)) \
+    X(void, DeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers)) \
+    X(void, DeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers)) \
+    X(void, DeleteProgram, (GLuint program), (program)) \
+    X(void, DeleteShader, (GLuint shader), (shader)) \
+    X(void, DeleteSync, (GLsync sync), (sync)) \
+    X(void, DeleteTextures, (GLsizei n, const GLuint* textures), (n, textures)) \
+    X(void, DeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays)) \
+    X(void, Disable, (GLenum cap), (cap)) \
+    X(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+    X(void, DrawBuffers, (GLsizei n, const GLenum* bufs), (n, bufs)) \
+    X(void, DrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount), (mode, count, type, indices, instancecount)) \
+    X(void, Enable, (GLenum cap), (cap)) \
+    X(void, EnableClientState, (GLenum array), (array)) \
+    X(GLsync, FenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+    X(void, Finish, (), ()) \
+    X(void, FramebufferTexture, (GLenum target, GLenum attachment, GLuint texture, GLint level), (target, attachment, texture, level)) \
+    X(void, GenBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+    X(void, GenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers)) \
+    X(void, GenTextures, (GLsizei n, GLuint* textures), (n, textures)) \
+    X(void, GenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+    X(void, GetIntegerv, (GLenum pname, GLint* data), (pname, data)) \
+    X(void, GetProgramBinary, (GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary), (program, bufSize, length, binaryFormat, binary)) \
+    X(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (program, bufSize, length, infoLog)) \
+    X(void, GetProgramiv, (GLuint program, GLenum pname, GLint* params), (program, pname, params)) \
+    X(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog)) \
+    X(void, GetShaderiv, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params)) \
+    X(const GLubyte*, GetString, (GLenum name), (name)) \
+    X(GLint, GetUniformLocation, (GLuint program, const GLchar* name), (program, name)) \
+    X(void, LinkProgram, (GLuint program), (program)) \
+    X(void*, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+    X(void, PixelStorei, (GLenum pname, GLint param), (pname, param)) \
+    X(void, ProgramBinary, (GLuint program, GLenum binaryFormat, const void* binary, GLsizei length), (program, binaryFormat, binary, length)) \
+    X(void, ProgramParameteri, (GLuint program, GLenum pname, GLint value), (program, pname, value)) \
+    X(void, ProgramUniform1f, (GLuint program, GLint location, GLfloat v0), (program, location, v0)) \
+    X(void, ProgramUniform1i, (GLuint program, GLint location, GLint v0), (program, location, v0)) \
+    X(void, ProgramUniform2f, (GLuint program, GLint location, GLfloat v0, GLfloat v1), (program, location, v0, v1)) \
+    X(void, ProgramUniform4f, (GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (program, location, v0, v1, v2, v3)) \
+    X(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels), (x, y, width, height, format, type, pixels)) \
+    X(void, Scissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height)) \
+    X(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length), (shader, count, string, length)) \
+    X(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+    X(void, TexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+    X(void, TexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height)) \
+    X(void, Uniform1f, (GLint location, GLfloat v0), (location, v0)) \
+    X(void, Uniform2fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value)) \
+    X(void, Uniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2)) \
+    X(void, Uniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3)) \
+    X(void, Uniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value)) \
+    X(void, UniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value)) \
+    X(GLboolean, UnmapBuffer, (GLenum target), (target)) \
+    X(void, UseProgram, (GLuint program), (program)) \
+    X(void, ValidateProgram, (GLuint program), (program)) \
+    X(void, VertexPointer, (GLint size, GLenum type, GLsizei stride, const void* pointer), (size, type, stride, pointer)) \
+    X(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height))
+
+#define GL_DISPATCH_MEMBER(ret, name, params, args) ret (GLAPIENTRY* name) params;
+#define GL_FUNCTION_ENUM(ret, name, params, args) GLFunction##name,
+
+// All GL calls go through this table, which calls the driver unless a
+// stand-in is installed with UseRecordingGL.
+struct GLDispatch
+{
+    GL_FUNCTIONS(GL_DISPATCH_MEMBER)
+};
+
+extern GLDispatch gl;
+
+enum GLFunction
+{
+    GL_FUNCTIONS(GL_FUNCTION_ENUM)
+    GLFunctionCount
+};
+
+extern const char* const GLFunctionNames[GLFunctionCount];
+
+// What the recording stand-in has seen since the last Reset
+struct GLStats
+{
+    size_t calls[GLFunctionCount];
+
+    // Buffer, texture, shader source and uniform data
+    size_t uploaded;
+
+    size_t draws;
+    // Vertices or indices submitted, times instances
+    size_t vertices;
+
+    // Binds, enables and other state setters, and how many of them set what was already set
+    size_t stateChanges;
+    size_t redundantChanges;
+
+    size_t Calls() const;
+    void Reset();
+};
+
+void UseNativeGL();
+
+// No context is needed while recording. GL objects must be created and
+// destroyed under the same backend.
+void UseRecordingGL();
+
+GLStats& RecordedGL();
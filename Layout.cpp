@@ -0,0 +1,368 @@
+#include "Layout.h"
+#include "Font.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <iterator>
+
+// Blocks are split once they hold twice this many paragraphs
+constexpr size_t BlockSize = 64;
+
+static size_t LowBit(size_t i)
+{
+    return i & (~i + 1);
+}
+
+void Fenwick::Assign(const vector<size_t>& counts)
+{
+    tree.assign(counts.size() + 1, 0);
+
+    for (size_t i = 1; i < tree.size(); i++)
+    {
+        tree[i] += counts[i - 1];
+
+        size_t parent = i + LowBit(i);
+        if (parent < tree.size())
+            tree[parent] += tree[i];
+    }
+}
+
+void Fenwick::Add(size_t index, ptrdiff_t delta)
+{
+    // Unsigned wraparound subtracts negative deltas
+    for (size_t i = index + 1; i < tree.size(); i += LowBit(i))
+        tree[i] += (size_t)delta;
+}
+
+size_t Fenwick::Prefix(size_t index) const
+{
+    size_t sum = 0;
+
+    for (size_t i = index; i > 0; i -= LowBit(i))
+        sum += tree[i];
+
+    return sum;
+}
+
+size_t Fenwick::Find(size_t value, size_t& rest) const
+{
+    size_t n = tree.size() - 1;
+    size_t index = 0;
+    size_t step = 1;
+
+    while (step * 2 <= n)
+        step *= 2;
+
+    for (; step > 0; step /= 2)
+        if (index + step <= n && tree[index + step] <= value)
+        {
+            index += step;
+            value -= tree[index];
+        }
+
+    rest = value;
+
+    return index;
+}
+
+Layout::Layout(Font& font, GLfloat width, GLfloat lineHeight, Alignment alignment) :
+    font(font),
+    width(width),
+    lineHeight(lineHeight),
+    alignment(alignment)
+{
+    SetText("");
+}
+
+Layout::~Layout()
+{
+}
+
+void Layout::SetText(const char* text)
+{
+    blocks.assign(1, vector<Paragraph>(1));
+    Wrap(blocks[0][0]);
+    Count();
+
+    Insert(0, 0, text);
+}
+
+void Layout::SetWidth(GLfloat width)
+{
+    Layout::width = width;
+
+    for (auto& b : blocks)
+        for (auto& p : b)
+            Wrap(p);
+
+    Count();
+}
+
+void Layout::SetAlignment(Alignment alignment)
+{
+    Layout::alignment = alignment;
+}
+
+void Layout::Wrap(Paragraph& paragraph)
+{
+    const string& text = paragraph.text;
+
+    paragraph.lines.clear();
+
+    size_t start = 0;
+
+    for (;;)
+    {
+        GLfloat pen = 0.f;
+        GLfloat breakWidth = 0.f;
+        size_t breakAt = start;
+        size_t i = start;
+
+        for (; i < text.size(); i++)
+        {
+            char c = text[i];
+
+            // Break before a run of spaces, which may hang past the width
+            if (c == ' ')
+            {
+                if (i > start && text[i - 1] != ' ')
+                {
+                    breakAt = i;
+                    breakWidth = pen;
+                }
+            }
+            else if (width > 0.f && i > start && pen + font.Advance(c) > width)
+                break;
+
+            pen += font.Advance(c);
+        }
+
+        if (i == text.size())
+        {
+            paragraph.lines.push_back({ start, i - start, pen });
+            return;
+        }
+
+        // A word wider than the line is broken where it overflows
+        if (breakAt == start)
+        {
+            paragraph.lines.push_back({ start, i - start, pen });
+            start = i;
+            continue;
+        }
+
+        paragraph.lines.push_back({ start, breakAt - start, breakWidth });
+
+        for (start = breakAt; start < text.size() && text[start] == ' '; start++);
+    }
+}
+
+void Layout::Count()
+{
+    vector<size_t> paragraphs(blocks.size());
+    vector<size_t> lines(blocks.size());
+
+    for (size_t b = 0; b < blocks.size(); b++)
+    {
+        paragraphs[b] = blocks[b].size();
+
+        for (auto& p : blocks[b])
+            lines[b] += p.lines.size();
+    }
+
+    paragraphCounts.Assign(paragraphs);
+    lineCounts.Assign(lines);
+}
+
+void Layout::Split(size_t block)
+{
+    vector<Paragraph> paragraphs = move(blocks[block]);
+    vector<vector<Paragraph>> split;
+
+    for (size_t i = 0; i < paragraphs.size(); i += BlockSize)
+    {
+        auto first = paragraphs.begin() + i;
+        auto last = paragraphs.begin() + min(i + BlockSize, paragraphs.size());
+
+        split.emplace_back(make_move_iterator(first), make_move_iterator(last));
+    }
+
+    blocks.erase(blocks.begin() + block);
+    blocks.insert(blocks.begin() + block, make_move_iterator(split.begin()), make_move_iterator(split.end()));
+
+    Count();
+}
+
+void Layout::Locate(size_t paragraph, size_t& block, size_t& index) const
+{
+    block = paragraphCounts.Find(paragraph, index);
+}
+
+const Paragraph& Layout::operator[](size_t index) const
+{
+    size_t b, i;
+    Locate(index, b, i);
+
+    return blocks[b][i];
+}
+
+size_t Layout::Top(size_t paragraph) const
+{
+    size_t b, i;
+    Locate(paragraph, b, i);
+
+    size_t top = lineCounts.Prefix(b);
+
+    for (size_t j = 0; j < i; j++)
+        top += blocks[b][j].lines.size();
+
+    return top;
+}
+
+void Layout::Insert(size_t paragraph, size_t offset, const char* str)
+{
+    size_t b, i;
+    Locate(paragraph, b, i);
+
+    vector<Paragraph>& block = blocks[b];
+    ptrdiff_t lines = -(ptrdiff_t)block[i].lines.size();
+
+    const char* end = strchr(str, '\n');
+
+    if (!end)
+        block[i].text.insert(offset, str);
+    else
+    {
+        string tail = block[i].text.substr(offset);
+
+        block[i].text.replace(offset, string::npos, str, end - str);
+
+        vector<Paragraph> inserted;
+
+        for (str = end + 1; ; str = end + 1)
+        {
+            end = strchr(str, '\n');
+
+            inserted.emplace_back();
+            inserted.back().text.assign(str, end ? end - str : strlen(str));
+
+            if (!end)
+                break;
+        }
+
+        inserted.back().text += tail;
+
+        for (auto& p : inserted)
+        {
+            Wrap(p);
+            lines += (ptrdiff_t)p.lines.size();
+        }
+
+        block.insert(block.begin() + i + 1, make_move_iterator(inserted.begin()), make_move_iterator(inserted.end()));
+        paragraphCounts.Add(b, (ptrdiff_t)inserted.size());
+    }
+
+    Wrap(block[i]);
+    lineCounts.Add(b, lines + (ptrdiff_t)block[i].lines.size());
+
+    if (block.size() > BlockSize * 2)
+        Split(b);
+}
+
+void Layout::Erase(size_t paragraph, size_t offset, size_t length)
+{
+    size_t b, i;
+    Locate(paragraph, b, i);
+
+    // Later blocks only shrink, so the paragraph stays where it is
+    Paragraph& p = blocks[b][i];
+    ptrdiff_t lines = -(ptrdiff_t)p.lines.size();
+
+    for (;;)
+    {
+        size_t erased = min(length, p.text.size() - offset);
+
+        p.text.erase(offset, erased);
+        length -= erased;
+
+        if (length == 0)
+            break;
+
+        // The next paragraph is joined, either in the same block or first in the next one
+        size_t nb = i + 1 < blocks[b].size() ? b : b + 1;
+        size_t ni = nb == b ? i + 1 : 0;
+
+        if (nb == blocks.size())
+            break;
+
+        vector<Paragraph>& next = blocks[nb];
+
+        p.text += next[ni].text;
+
+        paragraphCounts.Add(nb, -1);
+        lineCounts.Add(nb, -(ptrdiff_t)next[ni].lines.size());
+        next.erase(next.begin() + ni);
+
+        if (next.empty())
+        {
+            // The recount sees the old lines of the paragraph erased from, as the tree does
+            blocks.erase(blocks.begin() + nb);
+            Count();
+        }
+
+        // The paragraph break itself counts as one character
+        length--;
+    }
+
+    Wrap(p);
+    lineCounts.Add(b, lines + (ptrdiff_t)p.lines.size());
+}
+
+GLfloat Layout::Indent(const TextLine& line) const
+{
+    switch (alignment)
+    {
+    case Alignment::Center:
+        return (max(width, 0.f) - line.width) * 0.5f;
+    case Alignment::Right:
+        return max(width, 0.f) - line.width;
+    default:
+        return 0.f;
+    }
+}
+
+void Layout::Print(Renderer& renderer, float x, float y, size_t first, size_t count) const
+{
+    if (first >= Lines())
+        return;
+
+    size_t last = count < Lines() - first ? first + count : Lines();
+
+    // The block, paragraph and line in it of the first line
+    size_t i;
+    size_t b = lineCounts.Find(first, i);
+    size_t p = 0;
+
+    for (; i >= blocks[b][p].lines.size(); p++)
+        i -= blocks[b][p].lines.size();
+
+    string str;
+
+    for (size_t line = first; line < last; i = 0)
+    {
+        const Paragraph& paragraph = blocks[b][p];
+
+        for (; i < paragraph.lines.size() && line < last; i++, line++)
+        {
+            const TextLine& l = paragraph.lines[i];
+
+            str.assign(paragraph.text, l.start, l.length);
+            renderer.Print(font, x + Indent(l), y - (line + 1) * lineHeight, str.c_str());
+        }
+
+        if (++p == blocks[b].size())
+        {
+            b++;
+            p = 0;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <gl/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Font;
+class Renderer;
+
+enum class Alignment
+{
+    Left,
+    Center,
+    Right,
+};
+
+struct TextLine
+{
+    size_t start;
+    size_t length;
+    GLfloat width;
+};
+
+struct Paragraph
+{
+    string text;
+    vector<TextLine> lines;
+};
+
+// Sums of counts before an index, with both changing a count and finding the
+// index a running sum falls in taking logarithmic time
+class Fenwick
+{
+    // One-based, each entry summing the counts of the range its lowest bit spans
+    vector<size_t> tree;
+public:
+    void Assign(const vector<size_t>& counts);
+    void Add(size_t index, ptrdiff_t delta);
+
+    size_t Prefix(size_t index) const;
+
+    size_t Total() const
+    {
+        return Prefix(tree.size() - 1);
+    }
+
+    // Index whose count holds the value-th unit, with rest set to its place in it
+    size_t Find(size_t value, size_t& rest) const;
+};
+
+// Wraps paragraphs separated by '\n' to a width using the advances of a font.
+// Line breaks are kept per paragraph, so an edit only rewraps the paragraphs
+// it touches. Paragraphs are stored in blocks whose paragraph and line counts
+// are summed by Fenwick trees, so splitting or joining paragraphs only shifts
+// a block and finding a paragraph or line takes logarithmic time.
+class Layout
+{
+    Font& font;
+
+    GLfloat width;
+    GLfloat lineHeight;
+    Alignment alignment;
+
+    vector<vector<Paragraph>> blocks;
+    Fenwick paragraphCounts;
+    Fenwick lineCounts;
+
+    void Wrap(Paragraph& paragraph);
+    // Recounts every block, after blocks were added or removed
+    void Count();
+    void Split(size_t block);
+    void Locate(size_t paragraph, size_t& block, size_t& index) const;
+public:
+    // A width of zero or less never wraps
+    Layout(Font& font, GLfloat width, GLfloat lineHeight, Alignment alignment = Alignment::Left);
+    ~Layout();
+
+    void SetText(const char* text);
+    void SetWidth(GLfloat width);
+    void SetAlignment(Alignment alignment);
+
+    // Positions are a paragraph index and an offset in its text. Inserted '\n'
+    // split paragraphs, and erasing past the end of a paragraph joins the next.
+    void Insert(size_t paragraph, size_t offset, const char* str);
+    void Erase(size_t paragraph, size_t offset, size_t length);
+
+    size_t Paragraphs() const
+    {
+        return paragraphCounts.Total();
+    }
+
+    const Paragraph& operator[](size_t index) const;
+
+    size_t Lines() const
+    {
+        return lineCounts.Total();
+    }
+
+    // Index of the first line of a paragraph in the whole layout
+    size_t Top(size_t paragraph) const;
+
+    GLfloat Height() const
+    {
+        return Lines() * lineHeight;
+    }
+
+    // Horizontal position of a line relative to the layout's x, following the alignment
+    GLfloat Indent(const TextLine& line) const;
+
+    // Prints lines from first on downwards, with the top of the layout at y
+    void Print(Renderer& renderer, float x, float y, size_t first = 0, size_t count = SIZE_MAX) const;
+};
@@ -1,50 +1,179 @@
 #include "Program.h"
 #include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 
+// FNV-1a, enough to tell shader sources and drivers apart
+static uint64_t Hash(uint64_t hash, const char* str)
+{
+    for (; str && *str; str++)
+        hash = (hash ^ (unsigned char)*str) * 0x100000001b3ull;
+
+    return (hash ^ 0xff) * 0x100000001b3ull;
+}
+
+static ProgramStats stats = {};
+
+Shader* ShaderCache::Compile(GLenum type, const char* source)
+{
+    unique_ptr<Shader>& shader = shaders[make_pair(type, string(source))];
+
+    if (!shader)
+    {
+        shader.reset(new Shader(type));
+
+        if (!shader->Compile(source))
+        {
+            shader.reset();
+            return nullptr;
+        }
+    }
+
+    return shader.get();
+}
+
 Program::Program() :
-	id(glCreateProgram())
+	id(gl.CreateProgram())
 {
 }
 
 Program::~Program()
 {
-	glDeleteProgram(id);
+	gl.DeleteProgram(id);
 }
 
 bool Program::Link(Shader& vertex, Shader& fragment)
 {
-	glAttachShader(id, vertex);
-	glAttachShader(id, fragment);
+	gl.AttachShader(id, vertex);
+	gl.AttachShader(id, fragment);
 
-	glLinkProgram(id);
+	gl.LinkProgram(id);
     if (!CheckStatus(GL_LINK_STATUS))
         return false;
 
-    glValidateProgram(id);
+    gl.ValidateProgram(id);
     if (!CheckStatus(GL_VALIDATE_STATUS))
         return false;
 
     return true;
 }
 
+bool Program::Build(const char* vertex, const char* fragment, ShaderCache& shaders)
+{
+    auto begin = chrono::steady_clock::now();
+
+    GLint formats = 0;
+    gl.GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    uint64_t key = 0xcbf29ce484222325ull;
+    key = Hash(key, (const char*)gl.GetString(GL_VENDOR));
+    key = Hash(key, (const char*)gl.GetString(GL_RENDERER));
+    key = Hash(key, (const char*)gl.GetString(GL_VERSION));
+    key = Hash(key, vertex);
+    key = Hash(key, fragment);
+
+    ostringstream path;
+    path << "program-" << hex << setw(16) << setfill('0') << key << ".bin";
+
+    bool cached = formats > 0 && LoadBinary(path.str());
+
+    if (!cached)
+    {
+        Shader* vertexShader = shaders.Compile(GL_VERTEX_SHADER, vertex);
+        Shader* fragmentShader = shaders.Compile(GL_FRAGMENT_SHADER, fragment);
+
+        if (!vertexShader || !fragmentShader)
+            return false;
+
+        gl.ProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        if (!Link(*vertexShader, *fragmentShader))
+            return false;
+
+        if (formats > 0)
+            SaveBinary(path.str());
+    }
+
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - begin;
+
+    if (cached)
+    {
+        stats.loaded++;
+        stats.loadedMilliseconds += elapsed.count();
+    }
+    else
+    {
+        stats.compiled++;
+        stats.compiledMilliseconds += elapsed.count();
+    }
+
+    return true;
+}
+
+bool Program::LoadBinary(const string& path)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        return false;
+
+    GLenum format;
+    if (!file.read((char*)&format, sizeof(format)))
+        return false;
+
+    vector<char> binary((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    if (binary.empty())
+        return false;
+
+    // Rejected after a driver update, in which case the program is simply compiled again
+    gl.ProgramBinary(id, format, binary.data(), (GLsizei)binary.size());
+
+    GLint status;
+    gl.GetProgramiv(id, GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+void Program::SaveBinary(const string& path)
+{
+    GLint length = 0;
+    gl.GetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    GLenum format;
+    vector<char> binary(length);
+    gl.GetProgramBinary(id, length, &length, &format, binary.data());
+
+    ofstream file(path, ios::binary);
+    file.write((const char*)&format, sizeof(format));
+    file.write(binary.data(), length);
+}
+
+ProgramStats& Program::Stats()
+{
+    return stats;
+}
+
 void Program::PrepareLocations(initializer_list<const GLchar*> names)
 {
     for (auto& n : names)
-        uniforms.push_back(glGetUniformLocation(id, n));
+        uniforms.push_back(gl.GetUniformLocation(id, n));
 }
 
 GLint Program::CheckStatus(GLenum name)
 {
     GLint status;
-    glGetProgramiv(id, name, &status);
+    gl.GetProgramiv(id, name, &status);
     if (!status)
     {
         array<GLchar, 2048> log;
         GLsizei length;
-        glGetProgramInfoLog(id, log.size(), &length, log.data());
+        gl.GetProgramInfoLog(id, log.size(), &length, log.data());
         cout << log.data() << endl;
     }
     return status;
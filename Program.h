@@ -1,11 +1,42 @@
 #pragma once
 
 #include "Shader.h"
+#include <map>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <string>
 
 using namespace std;
 
+// Counts of the programs built so far and the time it took
+struct ProgramStats
+{
+	size_t compiled;
+	size_t loaded;
+	double compiledMilliseconds;
+	double loadedMilliseconds;
+
+	void Reset()
+	{
+		compiled = 0;
+		loaded = 0;
+		compiledMilliseconds = 0.;
+		loadedMilliseconds = 0.;
+	}
+};
+
+// Shaders compiled while building programs, so a source shared by several
+// programs is compiled once, and only if one of them isn't cached
+class ShaderCache
+{
+	// By type and source text, so equal sources share a shader wherever they are stored
+	map<pair<GLenum, string>, unique_ptr<Shader>> shaders;
+public:
+	// Returns null if the source fails to compile
+	Shader* Compile(GLenum type, const char* source);
+};
+
 class Program
 {
 	GLuint id;
@@ -13,11 +44,24 @@ class Program
 	vector<GLint> uniforms;
 
 	GLint CheckStatus(GLenum name);
+
+	bool LoadBinary(const string& path);
+	void SaveBinary(const string& path);
 public:
 	Program();
 	~Program();
 
 	bool Link(Shader& vertex, Shader& fragment);
+	// Compiles and links the sources, unless a binary of them cached by the same driver exists
+	bool Build(const char* vertex, const char* fragment, ShaderCache& shaders);
+
+	bool Build(const char* vertex, const char* fragment)
+	{
+		ShaderCache shaders;
+		return Build(vertex, fragment, shaders);
+	}
+
+	static ProgramStats& Stats();
 	void PrepareLocations(initializer_list<const GLchar*> names);
 
 	operator GLuint() const { return id; }
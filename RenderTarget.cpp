@@ -0,0 +1,72 @@
+#include "RenderTarget.h"
+#include <algorithm>
+#include <iostream>
+
+// Allocations are rounded up to this, so a live resize reallocates once per bucket crossed
+constexpr GLsizei Bucket = 256;
+
+bool RenderTarget::immutableStorage = false;
+
+RenderTarget::RenderTarget() :
+    width(0),
+    height(0),
+    capacityWidth(0),
+    capacityHeight(0),
+
+    framebuffers(2),
+    textures(2),
+    damaged(true)
+{
+}
+
+RenderTarget::~RenderTarget()
+{
+}
+
+bool RenderTarget::Resize(GLsizei width, GLsizei height)
+{
+    if ((RenderTarget::width == width && RenderTarget::height == height) || !width || !height)
+        return false;
+
+    RenderTarget::width = width;
+    RenderTarget::height = height;
+
+    damaged = true;
+
+    if (width <= capacityWidth && height <= capacityHeight)
+        return false;
+
+    capacityWidth = max(capacityWidth, (width + Bucket - 1) / Bucket * Bucket);
+    capacityHeight = max(capacityHeight, (height + Bucket - 1) / Bucket * Bucket);
+
+    // Immutable storage can't be respecified, so the textures are replaced either way
+    gl.DeleteTextures((GLsizei)textures.size(), textures.data());
+    gl.GenTextures((GLsizei)textures.size(), textures.data());
+
+    // The first texture is rasterized to, the second keeps the resolved frame
+    for (size_t i = 0; i < 2; i++)
+    {
+        gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+
+        gl.BindTexture(GL_TEXTURE_2D, textures[i]);
+        if (immutableStorage)
+            gl.TexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, capacityWidth, capacityHeight);
+        else
+            gl.TexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, capacityWidth, capacityHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+        gl.FramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textures[i], 0);
+
+        GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
+        gl.DrawBuffers(1, buffers);
+
+        if (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            cout << "Framebuffer creation failed" << endl;
+            exit(-1);
+        }
+    }
+
+    return true;
+}
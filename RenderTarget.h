@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Animation.h"
+#include "Buffer.h"
+#include <glm/mat4x4.hpp>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Font;
+
+struct PrintCommand
+{
+	Font* font;
+	float x;
+	float y;
+	string str;
+	glm::mat4 model;
+	Animation animation;
+	// Zero for static text, so it compares equal from frame to frame
+	float time;
+
+	bool operator==(const PrintCommand& other) const
+	{
+		return font == other.font && x == other.x && y == other.y && str == other.str && model == other.model &&
+			animation == other.animation && time == other.time;
+	}
+};
+
+// A surface to render to: one texture rasterized to and one keeping the
+// resolved frame. Their storage is allocated in buckets which only grow, so
+// resizing within the allocation just uses less or more of it. It is
+// immutable where the driver supports texture storage.
+class RenderTarget
+{
+	static bool immutableStorage;
+
+	GLsizei width;
+	GLsizei height;
+	GLsizei capacityWidth;
+	GLsizei capacityHeight;
+
+	Framebuffers framebuffers;
+	Textures textures;
+
+	// Prints of the frame being built and of the frame last drawn
+	vector<PrintCommand> commands;
+	vector<PrintCommand> drawn;
+	bool damaged;
+
+	friend class Renderer;
+public:
+	RenderTarget();
+	~RenderTarget();
+
+	// Set by the renderer once it knows what its context supports
+	static void SetImmutableStorage(bool immutableStorage)
+	{
+		RenderTarget::immutableStorage = immutableStorage;
+	}
+
+	// Returns whether the storage had to be reallocated
+	bool Resize(GLsizei width, GLsizei height);
+
+	void Invalidate()
+	{
+		damaged = true;
+	}
+
+	GLsizei Width() const
+	{
+		return width;
+	}
+
+	GLsizei Height() const
+	{
+		return height;
+	}
+
+	GLuint ResolvedFramebuffer() const
+	{
+		return framebuffers[1];
+	}
+};
@@ -1,6 +1,9 @@
 #include "Renderer.h"
 #include "Font.h"
 #include <iostream>
+#include <cfloat>
+#include <cmath>
+#include <glm/geometric.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 using namespace glm;
@@ -12,10 +15,13 @@ layout(location = 0) in vec2 position;
 
 out vec2 uv;
 
+uniform vec2 size;
+uniform vec4 rect;
+
 void main()
 {
     gl_Position = vec4((position - 0.5) * 2., 0., 1.);
-    uv = position;
+    uv = (rect.xy + position * rect.zw) / size;
 }
 )shader";
 
@@ -27,7 +33,7 @@ in vec2 uv;
 layout(location = 0) out vec4 color;
 
 uniform sampler2D screen;
-uniform float dx;
+uniform vec2 size;
 
 #define E 0.99
 #define Kernel vec3(0.2, 0.6, 0.2)
@@ -39,7 +45,7 @@ vec3 hit(vec3 v)
 
 void main()
 {
-    vec2 delta = vec2(dx, 0.);
+    vec2 delta = vec2(1. / size.x, 0.);
     vec3 center = texture(screen, uv).rgb;
     vec3 left = texture(screen, uv - delta).rgb;
     vec3 right = texture(screen, uv + delta).rgb;
@@ -56,18 +62,20 @@ void main()
 )shader";
 
 Renderer::Renderer() :
-	width(0),
-	height(0),
-
-	framebuffers(1),
-	textures(1),
     buffers(1),
     projection(identity<mat4>()),
-    model({identity<mat4>()})
+    model({identity<mat4>()}),
+    target(nullptr),
+    onDemand(false),
+    redraws(0),
+    time(0.f)
 {
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glClearColor(0., 0., 0., 1.);
-    glEnableClientState(GL_VERTEX_ARRAY);
+    // Texture storage is core since 4.2, while the shaders only need 4.1
+    RenderTarget::SetImmutableStorage(GLEW_VERSION_4_2 || GLEW_ARB_texture_storage);
+
+    gl.BlendFunc(GL_SRC_ALPHA, GL_ONE);
+    gl.ClearColor(0., 0., 0., 1.);
+    gl.EnableClientState(GL_VERTEX_ARRAY);
 
     float points[] =
     {
@@ -77,82 +85,106 @@ Renderer::Renderer() :
         0.f, 1.f,
     };
 
-    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(points), points, GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.BufferData(GL_ARRAY_BUFFER, sizeof(points), points, GL_STATIC_DRAW);
 
-    Shader vertex(GL_VERTEX_SHADER), fragment(GL_FRAGMENT_SHADER);
-
-    if (!vertex.Compile(VertexShader) ||
-        !fragment.Compile(FragmentShader) ||
-        !program.Link(vertex, fragment))
+    if (!program.Build(VertexShader, FragmentShader))
         exit(-1);
 
-    program.PrepareLocations({"dx", "screen"});
+    program.PrepareLocations({"size", "rect", "screen"});
 
-    glProgramUniform1i(program, program[1], 0);
+    gl.ProgramUniform1i(program, program[2], 0);
 }
 
 Renderer::~Renderer()
 {
 }
 
-void Renderer::BeginFrame(GLsizei width, GLsizei height)
+RenderTarget& Renderer::Target(size_t index)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+    while (targets.size() <= index)
+        targets.push_back(make_unique<RenderTarget>());
 
-	if ((Renderer::width != width || Renderer::height != height) && width && height)
-	{
-        Renderer::width = width;
-        Renderer::height = height;
+    return *targets[index];
+}
 
-        glBindTexture(GL_TEXTURE_2D, textures[0]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+void Renderer::BeginFrame(RenderTarget& target, GLsizei width, GLsizei height)
+{
+    Renderer::target = &target;
 
-        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textures[0], 0);
+    target.commands.clear();
+    target.Resize(width, height);
 
-        GLenum buffers[] = { GL_COLOR_ATTACHMENT0 };
-        glDrawBuffers(1, buffers);
+    projection = glm::ortho(-target.width / 2., target.width / 2., -target.height / 2., target.height / 2.);
+}
 
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        {
-            cout << "Framebuffer creation failed" << endl;
-            exit(-1);
-        }
+bool Renderer::EndFrame(GLint x, GLint y)
+{
+    RenderTarget& t = *target;
 
-        //glUseProgram(program);
-        glProgramUniform1f(program, program[0], 1.f / width);
+    if (onDemand && !t.damaged && t.commands == t.drawn)
+        return false;
 
-        projection = glm::ortho(-width / 2., width / 2., -height / 2., height / 2.);
-	}
+    Draw();
+    Present(t, x, y);
 
-    glViewport(0, 0, width, height);
-    glClear(GL_COLOR_BUFFER_BIT);
+    t.drawn.swap(t.commands);
+    t.damaged = false;
+    redraws++;
 
-    glEnable(GL_BLEND);
+    return true;
 }
 
-void Renderer::EndFrame()
+void Renderer::Draw()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Rasterize();
+    Resolve(0, 0, target->width, target->height);
+}
 
-    glViewport(0, 0, width, height);
+bool Renderer::Reaches(const PrintCommand& command, GLint x, GLint y, GLsizei width, GLsizei height) const
+{
+    // Animated glyphs may go anywhere
+    if (command.animation.effect != Effect::None)
+        return true;
 
-    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
-    glVertexPointer(2, GL_FLOAT, sizeof(float) * 2, 0);
+    vec4 b = command.font->Measure(command.str.c_str()).bounds;
+    if (b.x > b.z)
+        return false;
 
-    glUseProgram(program);
+    mat4 m = projection * command.model;
+    vec2 low(FLT_MAX), high(-FLT_MAX);
 
-    glDisable(GL_BLEND);
+    for (int i = 0; i < 4; i++)
+    {
+        vec4 corner = m * vec4(command.x + (i & 1 ? b.z : b.x), command.y + (i & 2 ? b.w : b.y), 0.f, 1.f);
+        vec2 pixel = (vec2(corner.x, corner.y) / corner.w * 0.5f + 0.5f) * vec2(target->width, target->height);
 
-    glBindTexture(GL_TEXTURE_2D, textures[0]);
+        low = glm::min(low, pixel);
+        high = glm::max(high, pixel);
+    }
 
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    // The subpixel samples spread glyphs by up to a pixel
+    return high.x + 1.f >= x && low.x - 1.f <= x + width && high.y + 1.f >= y && low.y - 1.f <= y + height;
 }
 
-void Renderer::Print(Font& font, float x, float y, const char* str)
+void Renderer::Rasterize(GLint x, GLint y, GLsizei width, GLsizei height)
 {
+    bool partial = x > 0 || y > 0 || width < target->width || height < target->height;
+
+    gl.BindFramebuffer(GL_FRAMEBUFFER, target->framebuffers[0]);
+
+    gl.Viewport(0, 0, target->width, target->height);
+
+    if (partial)
+    {
+        gl.Enable(GL_SCISSOR_TEST);
+        gl.Scissor(x, y, width, height);
+    }
+
+    gl.Clear(GL_COLOR_BUFFER_BIT);
+
+    gl.Enable(GL_BLEND);
+
     const float M = 0.5f;
     const float P = 1.f / 6.f;
     const float C = 1.f / 255.f;
@@ -177,5 +209,70 @@ void Renderer::Print(Font& font, float x, float y, const char* str)
         0.f, 0.f, C * 16.f, 1.f,
     };
 
-    font.Print(x, y, str, colors, samples, 6, *this);
+    for (auto& c : target->commands)
+    {
+        if (partial && !Reaches(c, x, y, width, height))
+            continue;
+
+        Push();
+        model.top() = c.model;
+
+        c.font->Print(c.x, c.y, c.str.c_str(), colors, samples, 6, *this, c.animation, c.time);
+
+        Pop();
+    }
+
+    if (partial)
+        gl.Disable(GL_SCISSOR_TEST);
+}
+
+void Renderer::Resolve(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    gl.BindFramebuffer(GL_FRAMEBUFFER, target->framebuffers[1]);
+
+    gl.Viewport(x, y, width, height);
+
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.VertexPointer(2, GL_FLOAT, sizeof(float) * 2, 0);
+
+    gl.UseProgram(program);
+
+    gl.ProgramUniform2f(program, program[0], (GLfloat)target->capacityWidth, (GLfloat)target->capacityHeight);
+    gl.ProgramUniform4f(program, program[1], (GLfloat)x, (GLfloat)y, (GLfloat)width, (GLfloat)height);
+
+    gl.Disable(GL_BLEND);
+
+    gl.BindTexture(GL_TEXTURE_2D, target->textures[0]);
+
+    gl.DrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+void Renderer::Present(const RenderTarget& target, GLint x, GLint y)
+{
+    gl.BindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffers[1]);
+    gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    gl.BlitFramebuffer(0, 0, target.width, target.height, x, y, x + target.width, y + target.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+float Renderer::PixelScale() const
+{
+    mat4 m = projection * Model();
+    vec2 half(target->width * 0.5f, target->height * 0.5f);
+
+    // The largest singular value of the linear part in pixels, which is how far it stretches any direction
+    vec2 x = vec2(m[0].x, m[0].y) * half;
+    vec2 y = vec2(m[1].x, m[1].y) * half;
+
+    float sum = dot(x, x) + dot(y, y);
+    float determinant = x.x * y.y - x.y * y.x;
+
+    return std::sqrt((sum + std::sqrt(std::max(sum * sum - 4.f * determinant * determinant, 0.f))) * 0.5f);
+}
+
+void Renderer::Print(Font& font, float x, float y, const char* str, const Animation& animation)
+{
+    target->commands.push_back({ &font, x, y, str, Model(), animation, animation.effect == Effect::None ? 0.f : time });
 }
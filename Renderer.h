@@ -2,8 +2,11 @@
 
 #include "Buffer.h"
 #include "Program.h"
+#include "RenderTarget.h"
 #include <glm/mat4x4.hpp>
+#include <memory>
 #include <stack>
+#include <vector>
 
 using namespace std;
 
@@ -11,24 +14,90 @@ class Font;
 
 class Renderer
 {
-	GLsizei width;
-	GLsizei height;
-
-	Framebuffers framebuffers;
-	Textures textures;
 	Buffers buffers;
 
 	Program program;
 
 	glm::mat4 projection;
 	stack<glm::mat4> model;
+
+	// Pool of targets sharing the programs and fonts, the first one for the window
+	vector<unique_ptr<RenderTarget>> targets;
+	// The one between BeginFrame and EndFrame
+	RenderTarget* target;
+
+	bool onDemand;
+	size_t redraws;
+
+	float time;
+
+	bool Reaches(const PrintCommand& command, GLint x, GLint y, GLsizei width, GLsizei height) const;
 public:
 	Renderer();
 	~Renderer();
 
-	void BeginFrame(GLsizei width, GLsizei height);
-	void EndFrame();
-	void Print(Font& font, float x, float y, const char* str);
+	// Prints are recorded between BeginFrame and EndFrame, which draws them and
+	// presents them at x, y of the window. In on-demand mode EndFrame draws
+	// nothing and returns false when the prints and the size are the same as in
+	// the last frame drawn to the target. Targets sharing a window which weren't
+	// redrawn must be presented again before swapping.
+	void BeginFrame(GLsizei width, GLsizei height)
+	{
+		BeginFrame(Target(0), width, height);
+	}
+
+	void BeginFrame(RenderTarget& target, GLsizei width, GLsizei height);
+	bool EndFrame(GLint x = 0, GLint y = 0);
+	// Animated prints are drawn as of the time set for the frame
+	void Print(Font& font, float x, float y, const char* str, const Animation& animation = Static);
+
+	// Rasterizes and resolves the recorded prints without presenting them
+	void Draw();
+	void Rasterize()
+	{
+		Rasterize(0, 0, target->width, target->height);
+	}
+
+	// Rasterizes a rectangle of the target, in pixels from its bottom left,
+	// leaving the rest as it was and skipping static prints which miss it
+	void Rasterize(GLint x, GLint y, GLsizei width, GLsizei height);
+	// Resolves a rectangle of the target, in pixels from its bottom left
+	void Resolve(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	// Copies the last resolved frame of a target to the window again
+	void Present(const RenderTarget& target, GLint x = 0, GLint y = 0);
+
+	void Present()
+	{
+		Present(Target(0));
+	}
+
+	RenderTarget& Target(size_t index);
+
+	// Seconds animations are evaluated at, usually set once a frame
+	void SetTime(float time)
+	{
+		Renderer::time = time;
+	}
+
+	void SetOnDemand(bool onDemand)
+	{
+		Renderer::onDemand = onDemand;
+	}
+
+	void Invalidate()
+	{
+		for (auto& t : targets)
+			t->Invalidate();
+	}
+
+	size_t Redraws() const
+	{
+		return redraws;
+	}
+
+	// Most pixels a model unit stretches to under the current transform, in any direction
+	float PixelScale() const;
 
 	const glm::mat4& Projection() const
 	{
@@ -0,0 +1,115 @@
+#include "ScrollView.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <glm/gtx/transform.hpp>
+
+ScrollView::ScrollView(Renderer& renderer) :
+    renderer(renderer),
+    front(0),
+    width(0),
+    height(0),
+    scale(0.f),
+    panX(0),
+    panY(0),
+    damaged(true),
+    exposed(0)
+{
+}
+
+ScrollView::~ScrollView()
+{
+}
+
+void ScrollView::Expose(RenderTarget& target, const ContentCallback& content, GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    // The subpixel filter reads a pixel to each side, and the copied pixels next
+    // to the strip were filtered without their neighbours outside the last frame
+    GLint left = max(x - 1, 0);
+    GLint right = min(x + width + 1, ScrollView::width);
+
+    GLint rasterLeft = max(left - 1, 0);
+    GLint rasterRight = min(right + 1, ScrollView::width);
+
+    // The rasterized pixels in content units, widened by the spread of the subpixel samples
+    glm::vec2 origin(ScrollView::width * 0.5f + panX, ScrollView::height * 0.5f + panY);
+    glm::vec4 rect(
+        (rasterLeft - 1 - origin.x) / scale, (y - 1 - origin.y) / scale,
+        (rasterRight + 1 - origin.x) / scale, (y + height + 1 - origin.y) / scale);
+
+    renderer.BeginFrame(target, ScrollView::width, ScrollView::height);
+
+    renderer.Push();
+    renderer.Multiply(glm::translate(glm::vec3((float)panX, (float)panY, 0.f)));
+    renderer.Multiply(glm::scale(glm::vec3(scale, scale, 1.f)));
+
+    content(renderer, rect);
+
+    renderer.Pop();
+
+    renderer.Rasterize(rasterLeft, y, rasterRight - rasterLeft, height);
+    renderer.Resolve(left, y, right - left, height);
+
+    exposed += (size_t)(right - left) * height;
+}
+
+bool ScrollView::Draw(GLsizei width, GLsizei height, float scale, glm::vec2 offset, const ContentCallback& content, GLint x, GLint y)
+{
+    GLint panX = (GLint)floor(offset.x * scale + 0.5f);
+    GLint panY = (GLint)floor(offset.y * scale + 0.5f);
+
+    GLint dx = panX - ScrollView::panX;
+    GLint dy = panY - ScrollView::panY;
+
+    bool full = damaged || width != ScrollView::width || height != ScrollView::height || scale != ScrollView::scale ||
+        abs(dx) >= width || abs(dy) >= height;
+
+    if (!full && !dx && !dy)
+        return false;
+
+    ScrollView::width = width;
+    ScrollView::height = height;
+    ScrollView::scale = scale;
+    ScrollView::panX = panX;
+    ScrollView::panY = panY;
+
+    RenderTarget& last = targets[front];
+    RenderTarget& next = targets[1 - front];
+
+    // Allocated before the last frame is copied into it
+    next.Resize(width, height);
+
+    if (full)
+        Expose(next, content, 0, 0, width, height);
+    else
+    {
+        // The part of the last frame still in view, where it is now
+        GLint x0 = max(dx, 0);
+        GLint x1 = min(width + dx, width);
+        GLint y0 = max(dy, 0);
+        GLint y1 = min(height + dy, height);
+
+        gl.BindFramebuffer(GL_READ_FRAMEBUFFER, last.ResolvedFramebuffer());
+        gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, next.ResolvedFramebuffer());
+        gl.BlitFramebuffer(x0 - dx, y0 - dy, x1 - dx, y1 - dy, x0, y0, x1, y1, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        // Columns uncovered on the left or right, then rows below or above between them
+        if (dx)
+            Expose(next, content, dx > 0 ? 0 : x1, 0, dx > 0 ? x0 : width - x1, height);
+        if (dy)
+            Expose(next, content, x0, dy > 0 ? 0 : y1, x1 - x0, dy > 0 ? y0 : height - y1);
+    }
+
+    renderer.Present(next, x, y);
+
+    front = 1 - front;
+    damaged = false;
+
+    return true;
+}
+
+void ScrollView::Present(GLint x, GLint y)
+{
+    renderer.Present(targets[front], x, y);
+}
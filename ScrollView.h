@@ -0,0 +1,62 @@
+#pragma once
+
+#include "RenderTarget.h"
+#include <functional>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+using namespace std;
+
+class Renderer;
+
+// Prints the content of the view reaching a rectangle, given as left, bottom,
+// right and top in content units. Prints missing it may be skipped, which
+// keeps the cost of a scrolled frame down to the strips it uncovers.
+typedef function<void(Renderer& renderer, const glm::vec4& rect)> ContentCallback;
+
+// Pans static text without redrawing it: the content is drawn into two
+// targets in turn, the last frame is copied into the other one shifted by the
+// pan, and only the strips it uncovers are rasterized and resolved. The pan
+// is snapped to whole pixels so copied and new pixels match. A change of size
+// or scale redraws everything, a change of content must be invalidated.
+class ScrollView
+{
+    Renderer& renderer;
+
+    RenderTarget targets[2];
+    // The target holding the last frame
+    size_t front;
+
+    GLsizei width;
+    GLsizei height;
+    float scale;
+    // Pan of the last frame, in pixels
+    GLint panX;
+    GLint panY;
+    bool damaged;
+
+    size_t exposed;
+
+    void Expose(RenderTarget& target, const ContentCallback& content, GLint x, GLint y, GLsizei width, GLsizei height);
+public:
+    ScrollView(Renderer& renderer);
+    ~ScrollView();
+
+    // Draws the content scaled and panned by offset content units and presents
+    // it at x, y of the window. Returns false when it is the same as last frame.
+    bool Draw(GLsizei width, GLsizei height, float scale, glm::vec2 offset, const ContentCallback& content, GLint x = 0, GLint y = 0);
+
+    // Copies the last frame to the window again
+    void Present(GLint x = 0, GLint y = 0);
+
+    void Invalidate()
+    {
+        damaged = true;
+    }
+
+    // Pixels rasterized and resolved so far
+    size_t Exposed() const
+    {
+        return exposed;
+    }
+};
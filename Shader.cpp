@@ -5,20 +5,20 @@
 using namespace std;
 
 Shader::Shader(GLenum type) :
-	id(glCreateShader(type))
+	id(gl.CreateShader(type))
 {
 }
 
 Shader::~Shader()
 {
-	glDeleteShader(id);
+	gl.DeleteShader(id);
 }
 
 bool Shader::Compile(const char* shader)
 {
 	GLint len = strlen(shader);
-	glShaderSource(id, 1, &shader, &len);
-    glCompileShader(id);
+	gl.ShaderSource(id, 1, &shader, &len);
+    gl.CompileShader(id);
 
     if (!CheckStatus(GL_COMPILE_STATUS))
         return false;
@@ -29,12 +29,12 @@ bool Shader::Compile(const char* shader)
 GLint Shader::CheckStatus(GLenum name)
 {
     GLint status;
-    glGetShaderiv(id, name, &status);
+    gl.GetShaderiv(id, name, &status);
     if (!status)
     {
         array<GLchar, 2048> log;
         GLsizei length;
-        glGetShaderInfoLog(id, log.size(), &length, log.data());
+        gl.GetShaderInfoLog(id, log.size(), &length, log.data());
         cout << log.data() << endl;
     }
     return status;
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <gl/glew.h>
+#include "GL.h"
 
 class Shader
 {
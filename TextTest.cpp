@@ -8,6 +8,8 @@
 #include <GLFW/glfw3.h>
 #include "Font.h"
 #include "Renderer.h"
+#include "ScrollView.h"
+#include "Benchmark.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
 
@@ -35,31 +37,25 @@ inline float tof(long l)
 struct DecompositionHelper
 {
     Font* font;
-    Glyph* glyph;
-    float t;
-    DrawParams params;
 };
 
 int moveTo(const FT_Vector* to, DecompositionHelper* helper)
 {
-    helper->font->AddContour(*helper->glyph, tof(to->x), tof(to->y), helper->t, helper->params);
-    helper->t = 1.f - helper->t;
+    helper->font->AddContour(tof(to->x), tof(to->y));
 
     return 0;
 }
 
 int lineTo(const FT_Vector* to, DecompositionHelper* helper)
 {
-    helper->font->AddLine(*helper->glyph, tof(to->x), tof(to->y), helper->t);
-    helper->t = 1.f - helper->t;
+    helper->font->AddLine(tof(to->x), tof(to->y));
 
     return 0;
 }
 
 int conicTo(const FT_Vector* control, const FT_Vector* to, DecompositionHelper* helper)
 {
-    helper->font->AddCurve(*helper->glyph, tof(control->x), tof(control->y), tof(to->x), tof(to->y), helper->t);
-    helper->t = 1.f - helper->t;
+    helper->font->AddCurve(tof(control->x), tof(control->y), tof(to->x), tof(to->y));
 
     return 0;
 }
@@ -105,6 +101,24 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     scale *= pow(1.1, yoffset);
 }
 
+void window_refresh_callback(GLFWwindow* window)
+{
+    Renderer* renderer = (Renderer*)glfwGetWindowUserPointer(window);
+
+    renderer->Present();
+
+    glfwSwapBuffers(window);
+}
+
+void scroll_refresh_callback(GLFWwindow* window)
+{
+    ScrollView* view = (ScrollView*)glfwGetWindowUserPointer(window);
+
+    view->Present();
+
+    glfwSwapBuffers(window);
+}
+
 void showFPS(GLFWwindow* window)
 {
     static double last = 0.;
@@ -131,6 +145,8 @@ void Load(Font& font, const char* filename, const char* str)
     error = FT_New_Face(library, filename, 0, &face);
     ft_error_fatal("FT_New_Face", error);
 
+    font.SetEm(tof(face->units_per_EM));
+
     size_t len = strlen(str);
 
     for (size_t i = 0; i < len; i++)
@@ -148,7 +164,7 @@ void Load(Font& font, const char* filename, const char* str)
 
         DecompositionHelper helper;
 
-        Glyph& glyph = font.CreateGlyph(str[i], tof(face->glyph->advance.x), helper.params);
+        Glyph& glyph = font.CreateGlyph(str[i], tof(face->glyph->advance.x));
 
         FT_Outline_Funcs funcs;
         funcs.move_to = (FT_Outline_MoveTo_Func)&moveTo;
@@ -159,13 +175,11 @@ void Load(Font& font, const char* filename, const char* str)
         funcs.shift = 0;
 
         helper.font = &font;
-        helper.glyph = &glyph;
-        helper.t = 0.f;
 
         FT_Error error = FT_Outline_Decompose(&outline, &funcs, &helper);
         ft_error_fatal("FT_Outline_Decompose", error);
 
-        font.FinishGlyph(glyph, helper.params);
+        font.FinishGlyph(glyph);
     }
 
     FT_Done_Face(face);
@@ -174,13 +188,23 @@ void Load(Font& font, const char* filename, const char* str)
     font.FillBuffers();
 }
 
-int main()
+int main(int argc, char** argv)
 {
     GLFWwindow* window;
 
+    bool benchmark = argc > 1 && strcmp(argv[1], "--benchmark") == 0;
+    bool scroll = argc > 1 && strcmp(argv[1], "--scroll") == 0;
+
     if (!glfwInit())
         return -1;
 
+    if (benchmark)
+    {
+        BenchmarkRecorded(FontName);
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     window = glfwCreateWindow(800, 600, Message, NULL, NULL);
     if (!window)
     {
@@ -194,34 +218,88 @@ int main()
 
     glewInit();
 
+    // Only the programs of this context
+    Program::Stats().Reset();
+
     Renderer renderer;
 
     Font font;
-    Load(font, FontName, Message);
+    Load(font, FontName, benchmark ? Printable : Message);
+
+    const ProgramStats& programs = Program::Stats();
+    cout << "Programs: " << programs.compiled << " compiled in " << programs.compiledMilliseconds << " ms, "
+        << programs.loaded << " loaded from cache in " << programs.loadedMilliseconds << " ms" << endl;
+
+    cout << "Overdraw: " << font.Overdraw() << endl;
+
+    if (benchmark)
+    {
+        BenchmarkMeasure(font);
+        BenchmarkLayout(font);
+        BenchmarkOnDemand(renderer, font);
+        BenchmarkLod(renderer, font);
+        BenchmarkScroll(renderer, font);
+        BenchmarkBatch(font);
+
+        glfwTerminate();
+        return 0;
+    }
+
+    // Only redraw when the text, the transform or the window size changed
+    renderer.SetOnDemand(true);
+
+    // Or only the strips uncovered by dragging, in scroll mode
+    ScrollView view(renderer);
+
+    if (scroll)
+    {
+        glfwSetWindowUserPointer(window, &view);
+        glfwSetWindowRefreshCallback(window, scroll_refresh_callback);
+    }
+    else
+    {
+        glfwSetWindowUserPointer(window, &renderer);
+        glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    }
 
     while (!glfwWindowShouldClose(window))
     {
         int width, height;
         glfwGetWindowSize(window, &width, &height);
 
-        renderer.BeginFrame(width, height);
+        bool drawn;
+
+        if (scroll)
+        {
+            drawn = view.Draw(width, height, scale, offset, [&](Renderer& renderer, const glm::vec4& rect)
+            {
+                renderer.Print(font, -80, -10, Message);
+            });
+        }
+        else
+        {
+            renderer.BeginFrame(width, height);
 
-        renderer.Push();
+            renderer.Push();
 
-        renderer.Multiply(glm::scale(glm::vec3(scale, scale, 1.f)));
-        renderer.Multiply(glm::translate(glm::vec3(offset.x, offset.y, 0.f)));
+            renderer.Multiply(glm::scale(glm::vec3(scale, scale, 1.f)));
+            renderer.Multiply(glm::translate(glm::vec3(offset.x, offset.y, 0.f)));
 
-        renderer.Print(font, -80, -10, Message);
+            renderer.Print(font, -80, -10, Message);
 
-        renderer.Pop();
+            renderer.Pop();
 
-        renderer.EndFrame();
+            drawn = renderer.EndFrame();
+        }
 
-        glfwSwapBuffers(window);
+        if (drawn)
+        {
+            glfwSwapBuffers(window);
 
-        glfwPollEvents();
+            showFPS(window);
+        }
 
-        showFPS(window);
+        glfwWaitEvents();
     }
 
     glfwTerminate();